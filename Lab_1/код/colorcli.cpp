@@ -0,0 +1,483 @@
+#include "colorcli.h"
+#include "colorkernels.h"
+#include "colorparser.h"
+#include "colornames.h"
+#include <QCommandLineParser>
+#include <QThread>
+#include <cstdio>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace
+{
+
+struct Range {
+    float min[3];
+    float max[3];
+};
+
+// Same limits ColorModel clamps its setters to
+const Range &rangeOf(ColorCli::Space space)
+{
+    static const Range rgbRange = { { 0, 0, 0 }, { 255, 255, 255 } };
+    static const Range hsvRange = { { 0, 0, 0 }, { 360, 100, 100 } };
+    static const Range xyzRange = { { 0, 0, 0 }, { 95.05f, 100.0f, 108.9f } };
+
+    switch (space) {
+    case ColorCli::Hsv: return hsvRange;
+    case ColorCli::Xyz: return xyzRange;
+    default: return rgbRange;
+    }
+}
+
+void printError(const QString &message)
+{
+    std::fputs(qPrintable(message), stderr);
+    std::fputc('\n', stderr);
+}
+
+qint64 readFully(QFile &input, char *data, qint64 size)
+{
+    qint64 total = 0;
+    while (total < size) {
+        qint64 n = input.read(data + total, size - total);
+        if (n <= 0) {
+            break;
+        }
+        total += n;
+    }
+    return total;
+}
+
+}
+
+ColorCli::ColorCli() :
+    m_from(Rgb),
+    m_to(Hsv),
+    m_binaryInput(false),
+    m_binaryOutput(false),
+    m_chunkSize(4 * 1024 * 1024),
+    m_line(0),
+    m_errorCount(0)
+{}
+
+bool ColorCli::isRequested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--cli") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ColorCli::parseSpace(const QString &name, Space &space)
+{
+    const QString lower = name.toLower();
+    if (lower == "rgb") space = Rgb;
+    else if (lower == "hex") space = Hex;
+    else if (lower == "hsv") space = Hsv;
+    else if (lower == "xyz") space = Xyz;
+    else if (lower == "name") space = Name;
+    else return false;
+    return true;
+}
+
+int ColorCli::recordSize(Space space) const
+{
+    return (space == Rgb || space == Hex) ? 3 : 3 * int(sizeof(float));
+}
+
+int ColorCli::run(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Batch color conversion between RGB, HEX, HSV and XYZ.\n"
+                                     "With --from rgb, CSS color names are accepted as input.");
+    parser.addHelpOption();
+
+    QCommandLineOption cliOption("cli", "Run without the GUI.");
+    QCommandLineOption fromOption("from", "Input color space: rgb, hex, hsv, xyz.", "space", "rgb");
+    QCommandLineOption toOption("to", "Output color space: rgb, hex, hsv, xyz, name (nearest CSS name).", "space", "hsv");
+    QCommandLineOption binaryInOption("binary-in", "Raw input: 3 bytes per RGB/HEX color, 3 floats per HSV/XYZ color.");
+    QCommandLineOption binaryOutOption("binary-out", "Raw output, same layout as --binary-in.");
+    QCommandLineOption threadsOption("threads", "Worker threads.", "count", QString::number(QThread::idealThreadCount()));
+    QCommandLineOption chunkOption("chunk", "Bytes read per chunk.", "bytes", QString::number(m_chunkSize));
+
+    parser.addOptions({ cliOption, fromOption, toOption, binaryInOption, binaryOutOption, threadsOption, chunkOption });
+    parser.addPositionalArgument("files", "Input files, stdin if omitted or '-'.", "[files...]");
+    parser.process(arguments);
+
+    if (!parseSpace(parser.value(fromOption), m_from) || !parseSpace(parser.value(toOption), m_to)) {
+        printError("Unknown color space, expected rgb, hex, hsv, xyz or name");
+        return 2;
+    }
+
+    m_binaryInput = parser.isSet(binaryInOption);
+    m_binaryOutput = parser.isSet(binaryOutOption);
+    if (m_from == Name || (m_to == Name && m_binaryOutput)) {
+        printError("Color names are only supported as text output");
+        return 2;
+    }
+    m_chunkSize = qMax(parser.value(chunkOption).toLongLong(), qint64(4096));
+    m_pool.setMaxThreadCount(qMax(parser.value(threadsOption).toInt(), 1));
+
+#ifdef Q_OS_WIN
+    if (m_binaryInput) _setmode(_fileno(stdin), _O_BINARY);
+    if (m_binaryOutput) _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    if (!m_output.open(stdout, QIODevice::WriteOnly)) {
+        printError("Cannot open stdout");
+        return 2;
+    }
+
+    QStringList files = parser.positionalArguments();
+    if (files.isEmpty()) {
+        files << "-";
+    }
+
+    bool ok = true;
+    for (const QString &fileName : files) {
+        QFile input;
+        bool opened;
+        if (fileName == "-") {
+            opened = input.open(stdin, QIODevice::ReadOnly);
+        } else {
+            input.setFileName(fileName);
+            opened = input.open(QIODevice::ReadOnly);
+        }
+        if (!opened) {
+            printError(QString("%1: %2").arg(fileName, input.errorString()));
+            ok = false;
+            continue;
+        }
+
+        m_inputName = (fileName == "-") ? QString("stdin") : fileName;
+        m_line = 0;
+        ok = processFile(input) && ok;
+    }
+
+    m_output.flush();
+    if (m_errorCount > 0) {
+        printError(QString("%1 invalid color(s) skipped").arg(m_errorCount));
+    }
+    return (ok && m_errorCount == 0) ? 0 : 1;
+}
+
+bool ColorCli::processFile(QFile &input)
+{
+    if (!m_binaryInput && !input.isSequential() && input.size() > 0) {
+        if (uchar *data = input.map(0, input.size())) {
+            processMapped(reinterpret_cast<const char *>(data), input.size());
+            input.unmap(data);
+            return true;
+        }
+    }
+
+    const int record = recordSize(m_from);
+    const qint64 chunkSize = m_binaryInput ? qMax(m_chunkSize / record, qint64(1)) * record : m_chunkSize;
+
+    QByteArray carry;
+    QByteArray active;
+    QVector<Slice> slices;
+    bool atEnd = false;
+
+    while (!atEnd || !slices.isEmpty()) {
+        QByteArray chunk;
+        if (!atEnd) {
+            chunk = carry;
+            const qint64 offset = chunk.size();
+            chunk.resize(offset + chunkSize);
+            const qint64 n = readFully(input, chunk.data() + offset, chunkSize);
+            chunk.resize(offset + n);
+            atEnd = n < chunkSize;
+
+            // Keep the incomplete tail for the next chunk
+            qint64 cut = chunk.size();
+            if (m_binaryInput) {
+                cut = cut / record * record;
+            } else if (!atEnd) {
+                cut = chunk.lastIndexOf('\n') + 1;
+            }
+            carry = chunk.mid(cut);
+            chunk.truncate(cut);
+        }
+
+        // The read above overlaps with the workers still busy on `active`
+        m_pool.waitForDone();
+        finishSlices(slices);
+
+        if (!chunk.isEmpty()) {
+            active = chunk;
+            startSlices(active.constData(), active.constData() + active.size(), slices);
+        }
+    }
+
+    if (m_binaryInput && !carry.isEmpty()) {
+        printError(QString("%1: trailing %2 byte(s) do not form a whole color").arg(m_inputName).arg(carry.size()));
+        return false;
+    }
+    return true;
+}
+
+void ColorCli::processMapped(const char *data, qint64 size)
+{
+    // Chunks are just windows into the mapping, nothing is copied
+    const char *end = data + size;
+    QVector<Slice> slices;
+
+    for (const char *pos = data; pos < end;) {
+        const char *chunkEnd = pos + qMin(m_chunkSize, qint64(end - pos));
+        if (chunkEnd < end) {
+            chunkEnd = ColorTextParser::findNewline(chunkEnd, end);
+            chunkEnd = chunkEnd < end ? chunkEnd + 1 : end;
+        }
+
+        startSlices(pos, chunkEnd, slices);
+        m_pool.waitForDone();
+        finishSlices(slices);
+        pos = chunkEnd;
+    }
+}
+
+void ColorCli::startSlices(const char *begin, const char *end, QVector<Slice> &slices)
+{
+    const int record = recordSize(m_from);
+    const int count = m_pool.maxThreadCount() * 4;
+    const qint64 step = qMax(qint64(end - begin) / count, qint64(record));
+
+    slices.clear();
+    slices.reserve(count + 1);
+
+    const char *pos = begin;
+    while (pos < end) {
+        const char *sliceEnd = pos + qMin(step, qint64(end - pos));
+        if (m_binaryInput) {
+            sliceEnd = pos + (sliceEnd - pos) / record * record;
+        } else if (sliceEnd < end) {
+            sliceEnd = ColorTextParser::findNewline(sliceEnd, end);
+            sliceEnd = sliceEnd < end ? sliceEnd + 1 : end;
+        }
+
+        Slice slice;
+        slice.begin = pos;
+        slice.end = sliceEnd;
+        slices.append(slice);
+        pos = sliceEnd;
+    }
+
+    // The vector is not resized from here on, so the pointers stay valid
+    for (Slice &slice : slices) {
+        Slice *target = &slice;
+        m_pool.start([this, target]() { processSlice(*target); });
+    }
+}
+
+void ColorCli::finishSlices(QVector<Slice> &slices)
+{
+    for (const Slice &slice : slices) {
+        m_output.write(slice.output);
+        for (const auto &error : slice.errors) {
+            printError(QString("%1:%2:%3: %4").arg(m_inputName).arg(m_line + error.line + 1)
+                           .arg(error.column).arg(error.message));
+        }
+        m_errorCount += slice.errors.size();
+        m_line += slice.lines;
+    }
+    slices.clear();
+}
+
+void ColorCli::processSlice(Slice &slice) const
+{
+    if (m_binaryInput) {
+        PlanarBuffer colors(int((slice.end - slice.begin) / recordSize(m_from)), 1);
+        int count = parseBinary(slice.begin, slice.end, colors);
+        if (count > 0) {
+            PlanarView view = colors.view();
+            view.width = count;
+            convert(view);
+            format(colors, count, slice.output);
+        }
+        return;
+    }
+
+    slice.lines = ColorTextParser::countLines(slice.begin, slice.end);
+    const int capacity = int(slice.lines) + 1;
+    PlanarBuffer colors(capacity, 1);
+    PlanarView view = colors.view();
+    int count;
+
+    if (m_from == Rgb || m_from == Hex) {
+        // Packed RGB32 goes into the kernels as an ImageView, no deinterleave pass
+        QVector<QRgb> packed(capacity);
+        count = int(ColorTextParser(m_from == Hex).parse(slice.begin, slice.end, packed.data(), &slice.errors));
+
+        ImageView source;
+        source.bits = reinterpret_cast<const uchar *>(packed.constData());
+        source.width = count;
+        source.height = 1;
+        source.bytesPerLine = count * qsizetype(sizeof(QRgb));
+        view.width = count;
+
+        if (m_to == Hsv) {
+            ColorKernels::rgbToHsv(source, view);
+        } else if (m_to == Xyz) {
+            ColorKernels::rgbToXyz(source, view);
+        } else {
+            ColorKernels::unpack(source, view);
+        }
+    } else {
+        count = parseText(slice.begin, slice.end, colors, slice);
+        view.width = count;
+        convert(view);
+    }
+
+    if (count > 0) {
+        format(colors, count, slice.output);
+    }
+}
+
+int ColorCli::parseText(const char *begin, const char *end, PlanarBuffer &colors, Slice &slice) const
+{
+    const Range &range = rangeOf(m_from);
+    float *planes[3] = { colors.plane(0), colors.plane(1), colors.plane(2) };
+    int count = 0;
+    qint64 line = 0;
+
+    const char *lineStart = begin;
+    while (lineStart < end) {
+        const char *lineEnd = ColorTextParser::findNewline(lineStart, end);
+        const char *p = lineStart;
+        const char *e = lineEnd;
+        while (p < e && (*p == ' ' || *p == '\t')) ++p;
+        while (e > p && (e[-1] == '\r' || e[-1] == ' ' || e[-1] == '\t')) --e;
+
+        if (p < e) {
+            float values[3];
+            const char *message = nullptr;
+            for (int i = 0; i < 3 && !message; ++i) {
+                if (i > 0) {
+                    if (p >= e || !ColorTextParser::isSeparator(*p)) {
+                        message = "expected ',' between components";
+                        break;
+                    }
+                    while (p < e && ColorTextParser::isSeparator(*p)) ++p;
+                }
+                if (!ColorTextParser::parseNumber(p, e, values[i])) {
+                    message = "expected a number";
+                }
+            }
+            if (!message && p != e) {
+                message = "unexpected characters after color";
+            }
+
+            if (!message) {
+                for (int i = 0; i < 3; ++i) {
+                    planes[i][count] = qBound(range.min[i], values[i], range.max[i]);
+                }
+                ++count;
+            } else {
+                slice.errors.append({ line, int(p - lineStart) + 1, message });
+            }
+        }
+
+        ++line;
+        lineStart = lineEnd + 1;
+    }
+
+    return count;
+}
+
+int ColorCli::parseBinary(const char *begin, const char *end, PlanarBuffer &colors) const
+{
+    const Range &range = rangeOf(m_from);
+    float *planes[3] = { colors.plane(0), colors.plane(1), colors.plane(2) };
+    const int record = recordSize(m_from);
+    int count = 0;
+
+    for (const char *p = begin; p + record <= end; p += record, ++count) {
+        for (int i = 0; i < 3; ++i) {
+            float value;
+            if (record == 3) {
+                value = float(uchar(p[i]));
+            } else {
+                std::memcpy(&value, p + i * sizeof(float), sizeof(float));
+            }
+            planes[i][count] = qBound(range.min[i], value, range.max[i]);
+        }
+    }
+
+    return count;
+}
+
+void ColorCli::convert(const PlanarView &view) const
+{
+    const bool fromRgb = m_from == Rgb || m_from == Hex;
+    const bool toRgb = m_to == Rgb || m_to == Hex || m_to == Name;
+    if (m_from == m_to || (fromRgb && toRgb)) {
+        return;
+    }
+
+    // Everything goes through RGB, exactly like ColorModel does
+    if (m_from == Hsv) {
+        ColorKernels::hsvToRgb(view, view);
+    } else if (m_from == Xyz) {
+        ColorKernels::xyzToRgb(view, view);
+    }
+
+    if (m_to == Hsv) {
+        ColorKernels::rgbToHsv(view, view);
+    } else if (m_to == Xyz) {
+        ColorKernels::rgbToXyz(view, view);
+    }
+}
+
+void ColorCli::format(const PlanarBuffer &colors, int count, QByteArray &output) const
+{
+    const float *planes[3] = { colors.plane(0), colors.plane(1), colors.plane(2) };
+    static const char digits[] = "0123456789ABCDEF";
+
+    if (m_binaryOutput) {
+        output.reserve(count * recordSize(m_to));
+        for (int i = 0; i < count; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                if (m_to == Rgb || m_to == Hex) {
+                    output.append(char(int(planes[c][i])));
+                } else {
+                    output.append(reinterpret_cast<const char *>(&planes[c][i]), sizeof(float));
+                }
+            }
+        }
+        return;
+    }
+
+    // Same precision as the spin boxes in MainWindow
+    const int precision = (m_to == Hsv) ? 1 : 3;
+    output.reserve(count * 24);
+    for (int i = 0; i < count; ++i) {
+        if (m_to == Name) {
+            output.append(ColorNames::nearestName(RGB(int(planes[0][i]), int(planes[1][i]), int(planes[2][i]))));
+        } else if (m_to == Hex) {
+            output.append('#');
+            for (int c = 0; c < 3; ++c) {
+                int value = int(planes[c][i]);
+                output.append(digits[value >> 4]);
+                output.append(digits[value & 0xf]);
+            }
+        } else {
+            for (int c = 0; c < 3; ++c) {
+                if (c > 0) output.append(',');
+                if (m_to == Rgb) {
+                    output.append(QByteArray::number(int(planes[c][i])));
+                } else {
+                    output.append(QByteArray::number(planes[c][i], 'f', precision));
+                }
+            }
+        }
+        output.append('\n');
+    }
+}
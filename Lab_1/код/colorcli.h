@@ -0,0 +1,62 @@
+#ifndef COLORCLI_H
+#define COLORCLI_H
+
+#include <QStringList>
+#include <QByteArray>
+#include <QFile>
+#include <QThreadPool>
+#include <QVector>
+#include "planarbuffer.h"
+#include "colorparser.h"
+
+// Headless batch converter:
+//   color_converter --cli --from hex --to hsv [files...]
+// Regular files are memory-mapped, other input is read in fixed-size
+// chunks. Every chunk is split into slices that are parsed, converted and
+// formatted on the thread pool, so memory use does not depend on input size.
+class ColorCli
+{
+public:
+    enum Space { Rgb, Hex, Hsv, Xyz, Name };
+
+    ColorCli();
+
+    static bool isRequested(int argc, char *argv[]);
+    int run(const QStringList &arguments);
+
+private:
+    struct Slice {
+        const char *begin = nullptr;
+        const char *end = nullptr;
+        QByteArray output;
+        QList<ColorParseError> errors;
+        qint64 lines = 0;
+    };
+
+    Space m_from;
+    Space m_to;
+    bool m_binaryInput;
+    bool m_binaryOutput;
+    qint64 m_chunkSize;
+    QThreadPool m_pool;
+    QFile m_output;
+    QString m_inputName;
+    qint64 m_line;
+    qint64 m_errorCount;
+
+    bool processFile(QFile &input);
+    void processMapped(const char *data, qint64 size);
+    void startSlices(const char *begin, const char *end, QVector<Slice> &slices);
+    void finishSlices(QVector<Slice> &slices);
+    void processSlice(Slice &slice) const;
+
+    int parseText(const char *begin, const char *end, PlanarBuffer &colors, Slice &slice) const;
+    int parseBinary(const char *begin, const char *end, PlanarBuffer &colors) const;
+    void convert(const PlanarView &view) const;
+    void format(const PlanarBuffer &colors, int count, QByteArray &output) const;
+
+    int recordSize(Space space) const;
+    static bool parseSpace(const QString &name, Space &space);
+};
+
+#endif // COLORCLI_H
@@ -0,0 +1,242 @@
+#include "colorkernels.h"
+
+// The row loops below are written as straight-line arithmetic with selects
+// instead of if/else chains so the compiler can vectorize them.
+
+namespace
+{
+
+inline float clampf(float value, float min, float max)
+{
+    return value < min ? min : (value > max ? max : value);
+}
+
+// Truncates like the int conversion in RGB(int, int, int)
+inline float toChannel(float value)
+{
+    return float(int(clampf(value * 255.0f, 0.0f, 255.0f)));
+}
+
+inline void hsvFromRgb(float red, float green, float blue, float &h, float &s, float &v)
+{
+    red *= 1.0f / 255.0f;
+    green *= 1.0f / 255.0f;
+    blue *= 1.0f / 255.0f;
+
+    float max = red > green ? red : green;
+    max = max > blue ? max : blue;
+    float min = red < green ? red : green;
+    min = min < blue ? min : blue;
+    float delta = max - min;
+    bool gray = delta < 0.0001f;
+    bool black = max < 0.0001f;
+    // Divide unconditionally so the selects stay branch-free
+    float inv = 1.0f / (gray ? 1.0f : delta);
+
+    float hue = red >= max ? (green - blue) * inv
+              : green >= max ? (blue - red) * inv + 2.0f
+                             : (red - green) * inv + 4.0f;
+    hue = gray ? 0.0f : hue * 60.0f;
+
+    h = hue < 0.0f ? hue + 360.0f : hue;
+    s = black ? 0.0f : delta / (black ? 1.0f : max) * 100.0f;
+    v = max * 100.0f;
+}
+
+inline void xyzFromLinear(float red, float green, float blue, float &x, float &y, float &z)
+{
+    x = red * 0.412453f + green * 0.35758f + blue * 0.180423f;
+    y = red * 0.212671f + green * 0.71516f + blue * 0.072169f;
+    z = red * 0.019334f + green * 0.119193f + blue * 0.950227f;
+}
+
+inline int lutIndex(float value)
+{
+    return int(clampf(value + 0.5f, 0.0f, 255.0f));
+}
+
+inline float companded(float value)
+{
+    return value >= 0.0031308f ? 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f : 12.92f * value;
+}
+
+}
+
+namespace ColorKernels
+{
+
+const float *linearTable()
+{
+    static const struct Table {
+        float values[256];
+        Table()
+        {
+            for (int i = 0; i < 256; ++i) {
+                values[i] = float(srgbToLinear(i / 255.0) * 100);
+            }
+        }
+    } table;
+    return table.values;
+}
+
+void unpack(const ImageView &src, const PlanarView &dst)
+{
+    const int width = qMin(src.width, dst.width);
+    const int height = qMin(src.height, dst.height);
+
+    for (int y = 0; y < height; ++y) {
+        const QRgb *line = src.scanLine(y);
+        float *r = dst.scanLine(0, y);
+        float *g = dst.scanLine(1, y);
+        float *b = dst.scanLine(2, y);
+        for (int x = 0; x < width; ++x) {
+            r[x] = float((line[x] >> 16) & 0xff);
+            g[x] = float((line[x] >> 8) & 0xff);
+            b[x] = float(line[x] & 0xff);
+        }
+    }
+}
+
+void pack(const PlanarView &src, QImage &dst)
+{
+    const int width = qMin(src.width, dst.width());
+    const int height = qMin(src.height, dst.height());
+
+    for (int y = 0; y < height; ++y) {
+        const float *r = src.scanLine(0, y);
+        const float *g = src.scanLine(1, y);
+        const float *b = src.scanLine(2, y);
+        QRgb *line = reinterpret_cast<QRgb *>(dst.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            line[x] = 0xff000000u
+                    | (quint32(lutIndex(r[x])) << 16)
+                    | (quint32(lutIndex(g[x])) << 8)
+                    | quint32(lutIndex(b[x]));
+        }
+    }
+}
+
+void rgbToHsv(const PlanarView &src, const PlanarView &dst)
+{
+    for (int y = 0; y < src.height; ++y) {
+        const float *r = src.scanLine(0, y);
+        const float *g = src.scanLine(1, y);
+        const float *b = src.scanLine(2, y);
+        float *h = dst.scanLine(0, y);
+        float *s = dst.scanLine(1, y);
+        float *v = dst.scanLine(2, y);
+        for (int x = 0; x < src.width; ++x) {
+            hsvFromRgb(r[x], g[x], b[x], h[x], s[x], v[x]);
+        }
+    }
+}
+
+void hsvToRgb(const PlanarView &src, const PlanarView &dst)
+{
+    for (int y = 0; y < src.height; ++y) {
+        const float *hp = src.scanLine(0, y);
+        const float *sp = src.scanLine(1, y);
+        const float *vp = src.scanLine(2, y);
+        float *r = dst.scanLine(0, y);
+        float *g = dst.scanLine(1, y);
+        float *b = dst.scanLine(2, y);
+        for (int x = 0; x < src.width; ++x) {
+            float h = clampf(hp[x], 0.0f, 360.0f);
+            float s = clampf(sp[x], 0.0f, 100.0f) / 100.0f;
+            float v = clampf(vp[x], 0.0f, 100.0f) / 100.0f;
+
+            float c = v * s;
+            float t = h / 60.0f;
+            float x2 = c * (1.0f - std::fabs(t - 2.0f * std::floor(t * 0.5f) - 1.0f));
+            float m = v - c;
+
+            float rr = (h < 60.0f || h >= 300.0f) ? c : ((h < 120.0f || h >= 240.0f) ? x2 : 0.0f);
+            float gg = h < 60.0f ? x2 : (h < 180.0f ? c : (h < 240.0f ? x2 : 0.0f));
+            float bb = h < 120.0f ? 0.0f : ((h < 180.0f || h >= 300.0f) ? x2 : c);
+
+            r[x] = toChannel(rr + m);
+            g[x] = toChannel(gg + m);
+            b[x] = toChannel(bb + m);
+        }
+    }
+}
+
+void rgbToXyz(const PlanarView &src, const PlanarView &dst)
+{
+    const float *lut = linearTable();
+
+    for (int y = 0; y < src.height; ++y) {
+        const float *r = src.scanLine(0, y);
+        const float *g = src.scanLine(1, y);
+        const float *b = src.scanLine(2, y);
+        float *xp = dst.scanLine(0, y);
+        float *yp = dst.scanLine(1, y);
+        float *zp = dst.scanLine(2, y);
+        for (int x = 0; x < src.width; ++x) {
+            xyzFromLinear(lut[lutIndex(r[x])], lut[lutIndex(g[x])], lut[lutIndex(b[x])],
+                          xp[x], yp[x], zp[x]);
+        }
+    }
+}
+
+void xyzToRgb(const PlanarView &src, const PlanarView &dst)
+{
+    for (int y = 0; y < src.height; ++y) {
+        const float *xp = src.scanLine(0, y);
+        const float *yp = src.scanLine(1, y);
+        const float *zp = src.scanLine(2, y);
+        float *r = dst.scanLine(0, y);
+        float *g = dst.scanLine(1, y);
+        float *b = dst.scanLine(2, y);
+        for (int x = 0; x < src.width; ++x) {
+            float cx = xp[x] / 100.0f;
+            float cy = yp[x] / 100.0f;
+            float cz = zp[x] / 100.0f;
+
+            float red = cx * 3.2406f + cy * -1.5372f + cz * -0.4986f;
+            float green = cx * -0.9689f + cy * 1.8758f + cz * 0.0415f;
+            float blue = cx * 0.0557f + cy * -0.2040f + cz * 1.0570f;
+
+            r[x] = toChannel(companded(red));
+            g[x] = toChannel(companded(green));
+            b[x] = toChannel(companded(blue));
+        }
+    }
+}
+
+void rgbToHsv(const ImageView &src, const PlanarView &dst)
+{
+    const int width = qMin(src.width, dst.width);
+    const int height = qMin(src.height, dst.height);
+
+    for (int y = 0; y < height; ++y) {
+        const QRgb *line = src.scanLine(y);
+        float *h = dst.scanLine(0, y);
+        float *s = dst.scanLine(1, y);
+        float *v = dst.scanLine(2, y);
+        for (int x = 0; x < width; ++x) {
+            hsvFromRgb(float((line[x] >> 16) & 0xff), float((line[x] >> 8) & 0xff), float(line[x] & 0xff),
+                       h[x], s[x], v[x]);
+        }
+    }
+}
+
+void rgbToXyz(const ImageView &src, const PlanarView &dst)
+{
+    const float *lut = linearTable();
+    const int width = qMin(src.width, dst.width);
+    const int height = qMin(src.height, dst.height);
+
+    for (int y = 0; y < height; ++y) {
+        const QRgb *line = src.scanLine(y);
+        float *xp = dst.scanLine(0, y);
+        float *yp = dst.scanLine(1, y);
+        float *zp = dst.scanLine(2, y);
+        for (int x = 0; x < width; ++x) {
+            xyzFromLinear(lut[(line[x] >> 16) & 0xff], lut[(line[x] >> 8) & 0xff], lut[line[x] & 0xff],
+                          xp[x], yp[x], zp[x]);
+        }
+    }
+}
+
+}
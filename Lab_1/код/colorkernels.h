@@ -0,0 +1,149 @@
+#ifndef COLORKERNELS_H
+#define COLORKERNELS_H
+
+#include "colortypes.h"
+#include "planarbuffer.h"
+#include <cmath>
+
+// Color space math shared by ColorModel and the batch conversion paths.
+// Scalar functions work on one color, planar kernels on whole PlanarViews.
+namespace ColorKernels
+{
+
+inline double clamp(double value, double min, double max)
+{
+    if (value < min) return min;
+    if (value > max) return max;
+    return value;
+}
+
+// sRGB companding, both sides in 0-1
+inline double srgbToLinear(double value)
+{
+    return (value >= 0.04045) ? std::pow((value + 0.055) / 1.055, 2.4) : value / 12.92;
+}
+
+inline double linearToSrgb(double value)
+{
+    return (value >= 0.0031308) ? (1.055 * std::pow(value, 1 / 2.4) - 0.055) : (12.92 * value);
+}
+
+inline HSV rgbToHsv(const RGB& rgb)
+{
+    double red = rgb.r / 255.0;
+    double green = rgb.g / 255.0;
+    double blue = rgb.b / 255.0;
+
+    double max = qMax(red, qMax(green, blue));
+    double min = qMin(red, qMin(green, blue));
+    double delta = max - min;
+
+    HSV hsv;
+
+    hsv.v = max * 100.0;
+
+    if (max < 0.0001) {
+        hsv.s = 0;
+    } else {
+        hsv.s = (delta / max) * 100.0;
+    }
+
+    if (delta < 0.0001) {
+        hsv.h = 0;
+    } else if (red >= max) {
+        hsv.h = 60.0 * std::fmod(((green - blue) / delta), 6.0);
+    } else if (green >= max) {
+        hsv.h = 60.0 * (((blue - red) / delta) + 2.0);
+    } else {
+        hsv.h = 60.0 * (((red - green) / delta) + 4.0);
+    }
+
+    if(hsv.h < 0) hsv.h +=360.0;
+
+    return hsv;
+}
+
+inline RGB hsvToRgb(const HSV& hsv)
+{
+    double h = clamp(hsv.h, 0, 360);
+    double s = clamp(hsv.s, 0, 100) / 100.0;
+    double v = clamp(hsv.v, 0, 100) / 100.0;
+
+    double c =v * s;
+    double x = c * (1 - std::fabs(std::fmod(h / 60.0, 2) - 1));
+    double m = v - c;
+
+    double r, g, b;
+
+    if (h < 60) {
+        r = c; g = x; b = 0;
+    } else if (h < 120) {
+        r = x; g = c; b = 0;
+    } else if (h < 180) {
+        r = 0; g = c; b = x;
+    } else if (h < 240) {
+        r = 0; g = x; b = c;
+    } else if (h < 300) {
+        r = x; g = 0; b = c;
+    } else {
+        r = c; g = 0; b = x;
+    }
+
+    return RGB(
+        clamp((r + m) * 255, 0, 255),
+        clamp((g + m) * 255, 0, 255),
+        clamp((b + m) * 255, 0, 255)
+        );
+}
+
+inline XYZ rgbToXyz(const RGB& rgb)
+{
+    double red = srgbToLinear(rgb.r / 255.0) * 100;
+    double green = srgbToLinear(rgb.g / 255.0) * 100;
+    double blue = srgbToLinear(rgb.b / 255.0) * 100;
+
+    double x = red * 0.412453 + green * 0.35758 + blue * 0.180423;
+    double y = red * 0.212671 + green * 0.71516 + blue * 0.072169;
+    double z = red * 0.019334 + green * 0.119193 + blue * 0.950227;
+
+    return XYZ(x, y, z);
+}
+
+inline RGB xyzToRgb(const XYZ& xyz)
+{
+    double x = xyz.x / 100.0;
+    double y = xyz.y / 100.0;
+    double z = xyz.z / 100.0;
+
+    double red = linearToSrgb(x * 3.2406 + y * -1.5372 + z * -0.4986);
+    double green = linearToSrgb(x * -0.9689 + y * 1.8758 + z * 0.0415);
+    double blue = linearToSrgb(x * 0.0557 + y * -0.2040 + z * 1.0570);
+
+    return RGB(
+        clamp(red * 255, 0, 255),
+        clamp(green * 255, 0, 255),
+        clamp(blue * 255, 0, 255)
+        );
+}
+
+// Linear-light value (0-100) for every 8-bit sRGB code
+const float *linearTable();
+
+// Planar kernels. Source and destination may be the same view (in-place).
+// They run in single precision, so a channel that lands exactly on an
+// integer boundary can differ by one from the scalar double path.
+void unpack(const ImageView &src, const PlanarView &dst);
+void pack(const PlanarView &src, QImage &dst);
+
+void rgbToHsv(const PlanarView &src, const PlanarView &dst);
+void hsvToRgb(const PlanarView &src, const PlanarView &dst);
+void rgbToXyz(const PlanarView &src, const PlanarView &dst);
+void xyzToRgb(const PlanarView &src, const PlanarView &dst);
+
+// Straight from QImage scanlines, no intermediate RGB planes
+void rgbToHsv(const ImageView &src, const PlanarView &dst);
+void rgbToXyz(const ImageView &src, const PlanarView &dst);
+
+}
+
+#endif // COLORKERNELS_H
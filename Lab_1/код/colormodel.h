@@ -4,19 +4,7 @@
 #include <QObject>
 #include <QColor>
 #include <QtMath>
-
-struct RGB{
-    int r, g, b;
-    RGB(int red = 0, int green = 0, int blue = 0) : r(red), g(green), b(blue) {}
-};
-struct HSV{
-    double h, s, v;
-    HSV(double hue = 0, double saturation = 0, double value = 0) : h(hue), s(saturation), v(value) {}
-};
-struct XYZ{
-    double x, y, z;
-    XYZ(double xVal = 0, double yVal = 0, double zVal = 0) : x(xVal), y(yVal), z(zVal) {}
-};
+#include "colortypes.h"
 
 class ColorModel : public QObject
 {
@@ -45,12 +33,14 @@ public:
     XYZ xyz() const;
     QColor color() const;
     bool isValid() const;
+    QString nearestColorName() const;
 
 public slots:
     void setRgb(const RGB&);
     void setHsv(const HSV&);
     void setXyz(const XYZ&);
     void setColor(const QColor &color);
+    void setColorName(const QString &name);
 
 signals:
     void colorChanged(const QColor &color);
@@ -0,0 +1,352 @@
+#include "colornames.h"
+#include "colorkernels.h"
+
+namespace
+{
+
+struct NamedColor {
+    const char *name;
+    quint32 rgb;
+};
+
+constexpr NamedColor namedColors[] = {
+    { "aliceblue", 0xf0f8ff },
+    { "antiquewhite", 0xfaebd7 },
+    { "aqua", 0x00ffff },
+    { "aquamarine", 0x7fffd4 },
+    { "azure", 0xf0ffff },
+    { "beige", 0xf5f5dc },
+    { "bisque", 0xffe4c4 },
+    { "black", 0x000000 },
+    { "blanchedalmond", 0xffebcd },
+    { "blue", 0x0000ff },
+    { "blueviolet", 0x8a2be2 },
+    { "brown", 0xa52a2a },
+    { "burlywood", 0xdeb887 },
+    { "cadetblue", 0x5f9ea0 },
+    { "chartreuse", 0x7fff00 },
+    { "chocolate", 0xd2691e },
+    { "coral", 0xff7f50 },
+    { "cornflowerblue", 0x6495ed },
+    { "cornsilk", 0xfff8dc },
+    { "crimson", 0xdc143c },
+    { "cyan", 0x00ffff },
+    { "darkblue", 0x00008b },
+    { "darkcyan", 0x008b8b },
+    { "darkgoldenrod", 0xb8860b },
+    { "darkgray", 0xa9a9a9 },
+    { "darkgreen", 0x006400 },
+    { "darkgrey", 0xa9a9a9 },
+    { "darkkhaki", 0xbdb76b },
+    { "darkmagenta", 0x8b008b },
+    { "darkolivegreen", 0x556b2f },
+    { "darkorange", 0xff8c00 },
+    { "darkorchid", 0x9932cc },
+    { "darkred", 0x8b0000 },
+    { "darksalmon", 0xe9967a },
+    { "darkseagreen", 0x8fbc8f },
+    { "darkslateblue", 0x483d8b },
+    { "darkslategray", 0x2f4f4f },
+    { "darkslategrey", 0x2f4f4f },
+    { "darkturquoise", 0x00ced1 },
+    { "darkviolet", 0x9400d3 },
+    { "deeppink", 0xff1493 },
+    { "deepskyblue", 0x00bfff },
+    { "dimgray", 0x696969 },
+    { "dimgrey", 0x696969 },
+    { "dodgerblue", 0x1e90ff },
+    { "firebrick", 0xb22222 },
+    { "floralwhite", 0xfffaf0 },
+    { "forestgreen", 0x228b22 },
+    { "fuchsia", 0xff00ff },
+    { "gainsboro", 0xdcdcdc },
+    { "ghostwhite", 0xf8f8ff },
+    { "gold", 0xffd700 },
+    { "goldenrod", 0xdaa520 },
+    { "gray", 0x808080 },
+    { "grey", 0x808080 },
+    { "green", 0x008000 },
+    { "greenyellow", 0xadff2f },
+    { "honeydew", 0xf0fff0 },
+    { "hotpink", 0xff69b4 },
+    { "indianred", 0xcd5c5c },
+    { "indigo", 0x4b0082 },
+    { "ivory", 0xfffff0 },
+    { "khaki", 0xf0e68c },
+    { "lavender", 0xe6e6fa },
+    { "lavenderblush", 0xfff0f5 },
+    { "lawngreen", 0x7cfc00 },
+    { "lemonchiffon", 0xfffacd },
+    { "lightblue", 0xadd8e6 },
+    { "lightcoral", 0xf08080 },
+    { "lightcyan", 0xe0ffff },
+    { "lightgoldenrodyellow", 0xfafad2 },
+    { "lightgray", 0xd3d3d3 },
+    { "lightgreen", 0x90ee90 },
+    { "lightgrey", 0xd3d3d3 },
+    { "lightpink", 0xffb6c1 },
+    { "lightsalmon", 0xffa07a },
+    { "lightseagreen", 0x20b2aa },
+    { "lightskyblue", 0x87cefa },
+    { "lightslategray", 0x778899 },
+    { "lightslategrey", 0x778899 },
+    { "lightsteelblue", 0xb0c4de },
+    { "lightyellow", 0xffffe0 },
+    { "lime", 0x00ff00 },
+    { "limegreen", 0x32cd32 },
+    { "linen", 0xfaf0e6 },
+    { "magenta", 0xff00ff },
+    { "maroon", 0x800000 },
+    { "mediumaquamarine", 0x66cdaa },
+    { "mediumblue", 0x0000cd },
+    { "mediumorchid", 0xba55d3 },
+    { "mediumpurple", 0x9370db },
+    { "mediumseagreen", 0x3cb371 },
+    { "mediumslateblue", 0x7b68ee },
+    { "mediumspringgreen", 0x00fa9a },
+    { "mediumturquoise", 0x48d1cc },
+    { "mediumvioletred", 0xc71585 },
+    { "midnightblue", 0x191970 },
+    { "mintcream", 0xf5fffa },
+    { "mistyrose", 0xffe4e1 },
+    { "moccasin", 0xffe4b5 },
+    { "navajowhite", 0xffdead },
+    { "navy", 0x000080 },
+    { "oldlace", 0xfdf5e6 },
+    { "olive", 0x808000 },
+    { "olivedrab", 0x6b8e23 },
+    { "orange", 0xffa500 },
+    { "orangered", 0xff4500 },
+    { "orchid", 0xda70d6 },
+    { "palegoldenrod", 0xeee8aa },
+    { "palegreen", 0x98fb98 },
+    { "paleturquoise", 0xafeeee },
+    { "palevioletred", 0xdb7093 },
+    { "papayawhip", 0xffefd5 },
+    { "peachpuff", 0xffdab9 },
+    { "peru", 0xcd853f },
+    { "pink", 0xffc0cb },
+    { "plum", 0xdda0dd },
+    { "powderblue", 0xb0e0e6 },
+    { "purple", 0x800080 },
+    { "rebeccapurple", 0x663399 },
+    { "red", 0xff0000 },
+    { "rosybrown", 0xbc8f8f },
+    { "royalblue", 0x4169e1 },
+    { "saddlebrown", 0x8b4513 },
+    { "salmon", 0xfa8072 },
+    { "sandybrown", 0xf4a460 },
+    { "seagreen", 0x2e8b57 },
+    { "seashell", 0xfff5ee },
+    { "sienna", 0xa0522d },
+    { "silver", 0xc0c0c0 },
+    { "skyblue", 0x87ceeb },
+    { "slateblue", 0x6a5acd },
+    { "slategray", 0x708090 },
+    { "slategrey", 0x708090 },
+    { "snow", 0xfffafa },
+    { "springgreen", 0x00ff7f },
+    { "steelblue", 0x4682b4 },
+    { "tan", 0xd2b48c },
+    { "teal", 0x008080 },
+    { "thistle", 0xd8bfd8 },
+    { "tomato", 0xff6347 },
+    { "turquoise", 0x40e0d0 },
+    { "violet", 0xee82ee },
+    { "wheat", 0xf5deb3 },
+    { "white", 0xffffff },
+    { "whitesmoke", 0xf5f5f5 },
+    { "yellow", 0xffff00 },
+    { "yellowgreen", 0x9acd32 },
+};
+
+constexpr int ColorCount = int(sizeof(namedColors) / sizeof(namedColors[0]));
+constexpr int TableSize = 256;
+constexpr int BucketCount = 64;
+constexpr int MaxNameLength = 32;
+
+constexpr char lower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+}
+
+constexpr qsizetype length(const char *name)
+{
+    qsizetype size = 0;
+    while (name[size]) ++size;
+    return size;
+}
+
+// FNV-1a over the lowercased name without spaces, with a final mix
+constexpr quint32 nameHash(const char *name, qsizetype size, quint32 seed)
+{
+    quint32 hash = 2166136261u ^ (seed * 0x9e3779b9u);
+    for (qsizetype i = 0; i < size; ++i) {
+        if (name[i] == ' ') continue;
+        hash ^= quint8(lower(name[i]));
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+// Hash-and-displace: keys are grouped into buckets, then every bucket
+// (largest first) gets the smallest seed that sends all of its keys to
+// free slots.
+struct PerfectHash {
+    quint16 seeds[BucketCount];
+    qint16 entries[TableSize];
+    bool valid;
+};
+
+constexpr PerfectHash buildPerfectHash()
+{
+    PerfectHash result {};
+    for (int i = 0; i < TableSize; ++i) {
+        result.entries[i] = -1;
+    }
+
+    int bucketOf[ColorCount] {};
+    int bucketSize[BucketCount] {};
+    for (int i = 0; i < ColorCount; ++i) {
+        bucketOf[i] = int(nameHash(namedColors[i].name, length(namedColors[i].name), 0) % BucketCount);
+        ++bucketSize[bucketOf[i]];
+    }
+
+    int order[BucketCount] {};
+    for (int i = 0; i < BucketCount; ++i) {
+        order[i] = i;
+    }
+    for (int i = 0; i < BucketCount; ++i) {
+        for (int j = i + 1; j < BucketCount; ++j) {
+            if (bucketSize[order[j]] > bucketSize[order[i]]) {
+                int tmp = order[i];
+                order[i] = order[j];
+                order[j] = tmp;
+            }
+        }
+    }
+
+    result.valid = true;
+    for (int b = 0; b < BucketCount && bucketSize[order[b]] > 0; ++b) {
+        const int bucket = order[b];
+        bool placed = false;
+
+        for (quint32 seed = 1; seed < 0xffff && !placed; ++seed) {
+            int chosen[ColorCount] {};
+            int count = 0;
+            bool ok = true;
+
+            for (int i = 0; i < ColorCount && ok; ++i) {
+                if (bucketOf[i] != bucket) continue;
+                int slot = int(nameHash(namedColors[i].name, length(namedColors[i].name), seed) & (TableSize - 1));
+                ok = result.entries[slot] < 0;
+                for (int k = 0; k < count && ok; ++k) {
+                    ok = chosen[k] != slot;
+                }
+                chosen[count++] = slot;
+            }
+
+            if (ok) {
+                count = 0;
+                for (int i = 0; i < ColorCount; ++i) {
+                    if (bucketOf[i] == bucket) {
+                        result.entries[chosen[count++]] = qint16(i);
+                    }
+                }
+                result.seeds[bucket] = quint16(seed);
+                placed = true;
+            }
+        }
+        result.valid = result.valid && placed;
+    }
+
+    return result;
+}
+
+constexpr PerfectHash perfectHash = buildPerfectHash();
+static_assert(perfectHash.valid, "No perfect hash found for the named color table");
+
+bool sameName(const char *key, const char *name, qsizetype size)
+{
+    qsizetype k = 0;
+    for (qsizetype i = 0; i < size; ++i) {
+        if (name[i] == ' ') continue;
+        if (key[k] == 0 || key[k] != lower(name[i])) return false;
+        ++k;
+    }
+    return key[k] == 0;
+}
+
+}
+
+namespace ColorNames
+{
+
+bool lookup(const char *name, qsizetype size, QRgb &rgb)
+{
+    const int bucket = int(nameHash(name, size, 0) % BucketCount);
+    const int slot = int(nameHash(name, size, perfectHash.seeds[bucket]) & (TableSize - 1));
+    const int index = perfectHash.entries[slot];
+
+    if (index < 0 || !sameName(namedColors[index].name, name, size)) {
+        return false;
+    }
+
+    rgb = 0xff000000u | namedColors[index].rgb;
+    return true;
+}
+
+bool lookup(QStringView name, QRgb &rgb)
+{
+    if (name.size() > MaxNameLength) {
+        return false;
+    }
+
+    char latin1[MaxNameLength];
+    for (qsizetype i = 0; i < name.size(); ++i) {
+        const char16_t c = name[i].unicode();
+        if (c > 0x7f) {
+            return false;
+        }
+        latin1[i] = char(c);
+    }
+    return lookup(latin1, name.size(), rgb);
+}
+
+const char *nearestName(const RGB &rgb, double *distance)
+{
+    static const struct Table {
+        XYZ values[ColorCount];
+        Table()
+        {
+            for (int i = 0; i < ColorCount; ++i) {
+                const quint32 c = namedColors[i].rgb;
+                values[i] = ColorKernels::rgbToXyz(RGB((c >> 16) & 0xff, (c >> 8) & 0xff, c & 0xff));
+            }
+        }
+    } table;
+
+    const XYZ xyz = ColorKernels::rgbToXyz(rgb);
+    int best = 0;
+    double bestDistance = -1;
+    for (int i = 0; i < ColorCount; ++i) {
+        const double dx = table.values[i].x - xyz.x;
+        const double dy = table.values[i].y - xyz.y;
+        const double dz = table.values[i].z - xyz.z;
+        const double d = dx * dx + dy * dy + dz * dz;
+        if (bestDistance < 0 || d < bestDistance) {
+            best = i;
+            bestDistance = d;
+        }
+    }
+
+    if (distance) {
+        *distance = std::sqrt(bestDistance);
+    }
+    return namedColors[best].name;
+}
+
+}
@@ -0,0 +1,23 @@
+#ifndef COLORNAMES_H
+#define COLORNAMES_H
+
+#include <QtGlobal>
+#include <QRgb>
+#include <QStringView>
+#include "colortypes.h"
+
+// CSS / SVG named colors (the same set QColor accepts) behind a perfect
+// hash that is built at compile time. Lookups are case-insensitive, ignore
+// spaces and never allocate.
+namespace ColorNames
+{
+
+bool lookup(const char *name, qsizetype length, QRgb &rgb);
+bool lookup(QStringView name, QRgb &rgb);
+
+// Closest named color, measured in XYZ. distance is 0 for an exact match.
+const char *nearestName(const RGB &rgb, double *distance = nullptr);
+
+}
+
+#endif // COLORNAMES_H
@@ -0,0 +1,311 @@
+#include "colorparser.h"
+#include "colornames.h"
+#include <QtAlgorithms>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define COLORPARSER_SSE2
+#endif
+
+namespace
+{
+
+const char *const InvalidHex = "invalid hex digit";
+const char *const HexLength = "expected 6 hex digits";
+const char *const InvalidNumber = "expected a number";
+const char *const ExpectedSeparator = "expected ',' between components";
+const char *const TrailingCharacters = "unexpected characters after color";
+const char *const UnknownName = "unknown color name";
+
+inline QRgb packRgb(int r, int g, int b)
+{
+    return 0xff000000u | (quint32(r) << 16) | (quint32(g) << 8) | quint32(b);
+}
+
+#ifndef COLORPARSER_SSE2
+inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+#endif
+
+// Six hex digits at p. Invalid input reports the offending column.
+bool decodeHex6(const char *p, const char *bufferEnd, QRgb &color, int &column)
+{
+#ifdef COLORPARSER_SSE2
+    char local[8] = { '0', '0', '0', '0', '0', '0', '0', '0' };
+    const char *src = p;
+    if (bufferEnd - p < 8) {
+        std::memcpy(local, p, 6);
+        src = local;
+    }
+
+    __m128i c = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src));
+    __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+
+    __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                    _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    __m128i isLetter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                     _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+
+    int valid = _mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) & 0x3f;
+    if (valid != 0x3f) {
+        column = qCountTrailingZeroBits(quint32(~valid));
+        return false;
+    }
+
+    __m128i digits = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i letters = _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10));
+    __m128i nibbles = _mm_or_si128(_mm_and_si128(isDigit, digits), _mm_andnot_si128(isDigit, letters));
+
+    // Each 16-bit lane holds (lo nibble byte, hi nibble byte) -> one byte
+    __m128i high = _mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0x00f0));
+    __m128i low = _mm_srli_epi16(nibbles, 8);
+    __m128i bytes = _mm_packus_epi16(_mm_or_si128(high, low), _mm_setzero_si128());
+
+    quint32 rgb = quint32(_mm_cvtsi128_si32(bytes));
+    color = packRgb(rgb & 0xff, (rgb >> 8) & 0xff, (rgb >> 16) & 0xff);
+    return true;
+#else
+    Q_UNUSED(bufferEnd);
+    int values[6];
+    for (int i = 0; i < 6; ++i) {
+        values[i] = hexValue(p[i]);
+        if (values[i] < 0) {
+            column = i;
+            return false;
+        }
+    }
+    color = packRgb(values[0] * 16 + values[1], values[2] * 16 + values[3], values[4] * 16 + values[5]);
+    return true;
+#endif
+}
+
+// Scalar decimal component, clamped the same way as ColorModel::setRgb
+bool parseComponent(const char *&pos, const char *end, int &value)
+{
+    float number;
+    if (!ColorTextParser::parseNumber(pos, end, number)) {
+        return false;
+    }
+    value = number <= 0 ? 0 : number >= 255 ? 255 : int(number);
+    return true;
+}
+
+#ifdef COLORPARSER_SSE2
+// Fast path for plain "ddd,ddd,ddd" lines of at most 16 bytes. Anything it
+// does not recognise goes through the scalar parser, which also produces
+// the error position.
+bool decodeTripleSse2(const char *p, int length, QRgb &color)
+{
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i digits = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                    _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    // Same set as ColorTextParser::isSeparator
+    __m128i isSep = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(',')),
+                                              _mm_cmpeq_epi8(c, _mm_set1_epi8(';'))),
+                                 _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')),
+                                              _mm_cmpeq_epi8(c, _mm_set1_epi8('\t'))));
+
+    const quint32 lineMask = (1u << length) - 1;
+    const quint32 digitMask = quint32(_mm_movemask_epi8(isDigit)) & lineMask;
+    const quint32 sepMask = quint32(_mm_movemask_epi8(isSep)) & lineMask;
+    if ((digitMask | sepMask) != lineMask || !(digitMask & 1) || !(digitMask & (1u << (length - 1)))) {
+        return false;
+    }
+
+    const quint32 starts = digitMask & ~(digitMask << 1);
+    if (qPopulationCount(starts) != 3) {
+        return false;
+    }
+
+    alignas(16) quint8 d[16];
+    _mm_store_si128(reinterpret_cast<__m128i *>(d), digits);
+
+    int values[3];
+    quint32 remaining = starts;
+    for (int i = 0; i < 3; ++i) {
+        int start = qCountTrailingZeroBits(remaining);
+        remaining &= remaining - 1;
+        int runLength = qCountTrailingZeroBits(~(digitMask >> start));
+        if (runLength > 3) {
+            return false;
+        }
+        int value = d[start];
+        for (int k = 1; k < runLength; ++k) {
+            value = value * 10 + d[start + k];
+        }
+        values[i] = qMin(value, 255);
+    }
+
+    color = packRgb(values[0], values[1], values[2]);
+    return true;
+}
+#endif
+
+}
+
+ColorTextParser::ColorTextParser(bool hexOnly) : m_hexOnly(hexOnly) {}
+
+bool ColorTextParser::parseNumber(const char *&pos, const char *end, float &value)
+{
+    const char *p = pos;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    double result = 0;
+    bool digits = false;
+    while (p < end && *p >= '0' && *p <= '9') {
+        result = result * 10 + (*p++ - '0');
+        digits = true;
+    }
+    if (p < end && *p == '.') {
+        ++p;
+        double scale = 0.1;
+        while (p < end && *p >= '0' && *p <= '9') {
+            result += (*p++ - '0') * scale;
+            scale *= 0.1;
+            digits = true;
+        }
+    }
+    if (!digits) {
+        return false;
+    }
+
+    value = float(negative ? -result : result);
+    pos = p;
+    return true;
+}
+
+const char *ColorTextParser::findNewline(const char *begin, const char *end)
+{
+    const char *p = begin;
+#ifdef COLORPARSER_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(c, newline));
+        if (mask) {
+            return p + qCountTrailingZeroBits(quint32(mask));
+        }
+    }
+#endif
+    const void *found = std::memchr(p, '\n', size_t(end - p));
+    return found ? static_cast<const char *>(found) : end;
+}
+
+qint64 ColorTextParser::countLines(const char *begin, const char *end)
+{
+    qint64 count = 0;
+    const char *p = begin;
+#ifdef COLORPARSER_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        count += qPopulationCount(quint32(_mm_movemask_epi8(_mm_cmpeq_epi8(c, newline))));
+    }
+#endif
+    for (; p < end; ++p) {
+        count += (*p == '\n');
+    }
+    return count;
+}
+
+qsizetype ColorTextParser::parse(const char *begin, const char *end, QRgb *out, QList<ColorParseError> *errors) const
+{
+    qsizetype count = 0;
+    qint64 line = 0;
+
+    const char *lineStart = begin;
+    while (lineStart < end) {
+        const char *lineEnd = findNewline(lineStart, end);
+        const char *p = lineStart;
+        const char *e = lineEnd;
+        while (p < e && (*p == ' ' || *p == '\t')) ++p;
+        while (e > p && (e[-1] == '\r' || e[-1] == ' ' || e[-1] == '\t')) --e;
+
+        if (p < e) {
+            int column = 0;
+            const char *message = nullptr;
+            if (parseLine(p, e, end, out[count], column, message)) {
+                ++count;
+            } else if (errors) {
+                errors->append({ line, int(p - lineStart) + column + 1, message });
+            }
+        }
+
+        ++line;
+        lineStart = lineEnd + 1;
+    }
+
+    return count;
+}
+
+bool ColorTextParser::parseLine(const char *begin, const char *end, const char *bufferEnd, QRgb &color, int &column, const char *&message) const
+{
+    const int length = int(end - begin);
+
+    if (*begin == '#' || m_hexOnly) {
+        const int offset = (*begin == '#') ? 1 : 0;
+        if (length - offset != 6) {
+            column = qMin(length, offset + 6);
+            message = HexLength;
+            return false;
+        }
+        if (!decodeHex6(begin + offset, bufferEnd, color, column)) {
+            column += offset;
+            message = InvalidHex;
+            return false;
+        }
+        return true;
+    }
+
+    if ((*begin >= 'a' && *begin <= 'z') || (*begin >= 'A' && *begin <= 'Z')) {
+        if (!ColorNames::lookup(begin, length, color)) {
+            column = 0;
+            message = UnknownName;
+            return false;
+        }
+        return true;
+    }
+
+#ifdef COLORPARSER_SSE2
+    if (length <= 16 && bufferEnd - begin >= 16 && decodeTripleSse2(begin, length, color)) {
+        return true;
+    }
+#endif
+
+    int values[3];
+    const char *p = begin;
+    for (int i = 0; i < 3; ++i) {
+        if (i > 0) {
+            if (p >= end || !ColorTextParser::isSeparator(*p)) {
+                column = int(p - begin);
+                message = ExpectedSeparator;
+                return false;
+            }
+            while (p < end && ColorTextParser::isSeparator(*p)) ++p;
+        }
+        if (!parseComponent(p, end, values[i])) {
+            column = int(p - begin);
+            message = InvalidNumber;
+            return false;
+        }
+    }
+    if (p != end) {
+        column = int(p - begin);
+        message = TrailingCharacters;
+        return false;
+    }
+
+    color = packRgb(values[0], values[1], values[2]);
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef COLORPARSER_H
+#define COLORPARSER_H
+
+#include <QtGlobal>
+#include <QList>
+#include <QRgb>
+
+struct ColorParseError {
+    qint64 line;         // 0-based, relative to the parsed range
+    int column;          // 1-based
+    const char *message;
+};
+
+// Bulk parser for "#RRGGBB", "r,g,b" and CSS color name lines, typically
+// run straight over a QFile::map() region. Output is packed 0xffRRGGBB, the
+// same layout as QImage::Format_RGB32, so the result can be wrapped in an
+// ImageView and handed to ColorKernels without another copy.
+// Character classification and hex decoding use SSE2 where available.
+class ColorTextParser
+{
+public:
+    // Without '#', six hex digits are only accepted when hexOnly is set;
+    // otherwise the line is read as a color name or a decimal triple.
+    explicit ColorTextParser(bool hexOnly = false);
+
+    // Number of '\n' in [begin, end)
+    static qint64 countLines(const char *begin, const char *end);
+    // First '\n' in [begin, end), or end
+    static const char *findNewline(const char *begin, const char *end);
+
+    // Component separators of "r,g,b" lines. Shared with ColorCli so that
+    // both read the same triples.
+    static bool isSeparator(char c) { return c == ',' || c == ';' || c == ' ' || c == '\t'; }
+    // Decimal number with optional sign and fraction, no exponent;
+    // advances pos on success
+    static bool parseNumber(const char *&pos, const char *end, float &value);
+
+    // Parses every line of [begin, end) into out, which must have room for
+    // countLines() + 1 colors. Empty lines are skipped. Returns the number
+    // of colors written.
+    qsizetype parse(const char *begin, const char *end, QRgb *out, QList<ColorParseError> *errors) const;
+
+private:
+    bool m_hexOnly;
+
+    bool parseLine(const char *begin, const char *end, const char *bufferEnd, QRgb &color, int &column, const char *&message) const;
+};
+
+#endif // COLORPARSER_H
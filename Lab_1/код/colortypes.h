@@ -0,0 +1,17 @@
+#ifndef COLORTYPES_H
+#define COLORTYPES_H
+
+struct RGB{
+    int r, g, b;
+    RGB(int red = 0, int green = 0, int blue = 0) : r(red), g(green), b(blue) {}
+};
+struct HSV{
+    double h, s, v;
+    HSV(double hue = 0, double saturation = 0, double value = 0) : h(hue), s(saturation), v(value) {}
+};
+struct XYZ{
+    double x, y, z;
+    XYZ(double xVal = 0, double yVal = 0, double zVal = 0) : x(xVal), y(yVal), z(zVal) {}
+};
+
+#endif // COLORTYPES_H
@@ -1,8 +1,15 @@
 #include "mainwindow.h"
+#include "colorcli.h"
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    if (ColorCli::isRequested(argc, argv)) {
+        QCoreApplication a(argc, argv);
+        ColorCli cli;
+        return cli.run(a.arguments());
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
@@ -0,0 +1,114 @@
+#include "planarbuffer.h"
+#include "colorkernels.h"
+#include <utility>
+
+ImageView ImageView::fromImage(const QImage &image)
+{
+    ImageView view;
+    if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32) {
+        return view;
+    }
+
+    view.bits = image.constBits();
+    view.width = image.width();
+    view.height = image.height();
+    view.bytesPerLine = image.bytesPerLine();
+    return view;
+}
+
+PlanarBuffer::PlanarBuffer() :
+    m_data(nullptr),
+    m_width(0),
+    m_height(0),
+    m_stride(0),
+    m_planeSize(0)
+{}
+
+PlanarBuffer::PlanarBuffer(int width, int height) : PlanarBuffer()
+{
+    resize(width, height);
+}
+
+PlanarBuffer::PlanarBuffer(PlanarBuffer &&other) noexcept :
+    m_data(std::exchange(other.m_data, nullptr)),
+    m_width(std::exchange(other.m_width, 0)),
+    m_height(std::exchange(other.m_height, 0)),
+    m_stride(std::exchange(other.m_stride, 0)),
+    m_planeSize(std::exchange(other.m_planeSize, 0))
+{}
+
+PlanarBuffer &PlanarBuffer::operator=(PlanarBuffer &&other) noexcept
+{
+    std::swap(m_data, other.m_data);
+    std::swap(m_width, other.m_width);
+    std::swap(m_height, other.m_height);
+    std::swap(m_stride, other.m_stride);
+    std::swap(m_planeSize, other.m_planeSize);
+    return *this;
+}
+
+PlanarBuffer::~PlanarBuffer()
+{
+    qFreeAligned(m_data);
+}
+
+void PlanarBuffer::resize(int width, int height)
+{
+    const qsizetype floatsPerLine = Alignment / qsizetype(sizeof(float));
+
+    qFreeAligned(m_data);
+    m_data = nullptr;
+    m_width = qMax(width, 0);
+    m_height = qMax(height, 0);
+
+    // Pad rows so every scanline starts on a 64-byte boundary
+    m_stride = (m_width + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+    m_planeSize = m_stride * m_height;
+
+    if (m_planeSize > 0) {
+        m_data = static_cast<float *>(qMallocAligned(3 * m_planeSize * sizeof(float), Alignment));
+        Q_CHECK_PTR(m_data);
+    }
+}
+
+PlanarView PlanarBuffer::view()
+{
+    PlanarView view;
+    if (isNull()) {
+        return view;
+    }
+
+    view.planes[0] = plane(0);
+    view.planes[1] = plane(1);
+    view.planes[2] = plane(2);
+    view.width = m_width;
+    view.height = m_height;
+    view.stride = m_stride;
+    return view;
+}
+
+PlanarBuffer PlanarBuffer::fromImage(const QImage &image)
+{
+    ImageView source = ImageView::fromImage(image);
+    QImage converted;
+    if (source.isNull()) {
+        converted = image.convertToFormat(QImage::Format_RGB32);
+        source = ImageView::fromImage(converted);
+    }
+
+    PlanarBuffer buffer(source.width, source.height);
+    ColorKernels::unpack(source, buffer.view());
+    return buffer;
+}
+
+QImage PlanarBuffer::toImage() const
+{
+    QImage image(m_width, m_height, QImage::Format_RGB32);
+    if (image.isNull()) {
+        return image;
+    }
+
+    // The kernels only read through the view, so the const_cast is safe
+    ColorKernels::pack(const_cast<PlanarBuffer *>(this)->view(), image);
+    return image;
+}
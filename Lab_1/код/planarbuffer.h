@@ -0,0 +1,77 @@
+#ifndef PLANARBUFFER_H
+#define PLANARBUFFER_H
+
+#include <QImage>
+#include <QtGlobal>
+
+// Non-owning view over three float planes (R/G/B, H/S/V or X/Y/Z).
+// This is what the batch conversion kernels operate on.
+struct PlanarView
+{
+    float *planes[3] = { nullptr, nullptr, nullptr };
+    int width = 0;
+    int height = 0;
+    qsizetype stride = 0; // in floats
+
+    bool isNull() const { return planes[0] == nullptr; }
+    float *scanLine(int plane, int y) const { return planes[plane] + y * stride; }
+};
+
+// Zero-copy view over the scanlines of a 32-bit QImage (RGB32 / ARGB32).
+struct ImageView
+{
+    const uchar *bits = nullptr;
+    int width = 0;
+    int height = 0;
+    qsizetype bytesPerLine = 0;
+
+    bool isNull() const { return bits == nullptr; }
+    const QRgb *scanLine(int y) const { return reinterpret_cast<const QRgb *>(bits + y * bytesPerLine); }
+
+    // Returns a null view if the image is not stored as 0xAARRGGBB
+    static ImageView fromImage(const QImage &image);
+};
+
+// Structure-of-arrays buffer: three separately addressable planes, each
+// 64-byte aligned, with rows padded to a multiple of 64 bytes.
+class PlanarBuffer
+{
+public:
+    static constexpr int Alignment = 64;
+
+    PlanarBuffer();
+    PlanarBuffer(int width, int height);
+    PlanarBuffer(PlanarBuffer &&other) noexcept;
+    PlanarBuffer &operator=(PlanarBuffer &&other) noexcept;
+    PlanarBuffer(const PlanarBuffer &) = delete;
+    PlanarBuffer &operator=(const PlanarBuffer &) = delete;
+    ~PlanarBuffer();
+
+    void resize(int width, int height);
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    qsizetype stride() const { return m_stride; }
+    bool isNull() const { return m_data == nullptr; }
+
+    float *plane(int index) { return m_data + index * m_planeSize; }
+    const float *plane(int index) const { return m_data + index * m_planeSize; }
+    float *scanLine(int plane, int y) { return this->plane(plane) + y * m_stride; }
+    const float *scanLine(int plane, int y) const { return this->plane(plane) + y * m_stride; }
+
+    PlanarView view();
+
+    // Deinterleaves an image into R/G/B planes (0-255)
+    static PlanarBuffer fromImage(const QImage &image);
+    // Interleaves R/G/B planes back into an RGB32 image
+    QImage toImage() const;
+
+private:
+    float *m_data;
+    int m_width;
+    int m_height;
+    qsizetype m_stride;
+    qsizetype m_planeSize;
+};
+
+#endif // PLANARBUFFER_H
@@ -0,0 +1,321 @@
+#include "analysiscache.h"
+#include "analysisprofiler.h"
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QMutexLocker>
+#include <QtEndian>
+
+namespace {
+
+const quint32 CacheMagic = 0x49414348;   // "IACH"
+const quint32 CacheVersion = 9;          // увеличивать при изменении полей ImageInfo
+const qint64 HeaderSize = 8;
+const int LockTimeout = 1000;            // мс ожидания блокировки другого процесса
+
+// Запись: quint32 длина (big-endian), затем полезная нагрузка QDataStream:
+// путь, размер, время изменения, хэш, флаг статистики по пикселям, ImageInfo
+void setStreamVersion(QDataStream &stream)
+{
+    stream.setVersion(QDataStream::Qt_6_0);
+}
+
+}
+
+CacheKey CacheKey::forFile(const QString &filePath, bool withHash)
+{
+    QFileInfo fileInfo(filePath);
+
+    CacheKey key;
+    key.size = fileInfo.size();
+    key.modified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    if (withHash) {
+        QFile file(filePath);
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        if (file.open(QIODevice::ReadOnly) && hash.addData(&file)) {
+            key.hash = hash.result();
+        }
+    }
+    return key;
+}
+
+AnalysisCache::AnalysisCache()
+    : lock(nullptr), mapped(nullptr), mappedSize(0), staleRecords(0)
+{
+}
+
+AnalysisCache::~AnalysisCache()
+{
+    close();
+}
+
+bool AnalysisCache::open(const QString &fileName)
+{
+    close();
+
+    QString path = fileName;
+    if (path.isEmpty()) {
+        QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        QDir().mkpath(dir);
+        path = dir + "/analysis.cache";
+    }
+
+    // Блокировка держится всё время, пока кэш открыт, поэтому устаревшей
+    // она считается только после завершения процесса-владельца
+    lock = new QLockFile(path + ".lock");
+    lock->setStaleLockTime(0);
+    if (!lock->tryLock(LockTimeout)) {
+        delete lock;
+        lock = nullptr;
+        return false;
+    }
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadWrite)) {
+        close();
+        return false;
+    }
+
+    // Файл другой версии не читается, а начинается заново
+    QByteArray header = file.read(HeaderSize);
+    if (header.size() != HeaderSize
+        || qFromBigEndian<quint32>(header.constData()) != CacheMagic
+        || qFromBigEndian<quint32>(header.constData() + 4) != CacheVersion) {
+        file.resize(0);
+        file.seek(0);
+        uchar fresh[HeaderSize];
+        qToBigEndian(CacheMagic, fresh);
+        qToBigEndian(CacheVersion, fresh + 4);
+        file.write(reinterpret_cast<const char *>(fresh), HeaderSize);
+        file.flush();
+    }
+
+    remap();
+    if (staleRecords > 1000 && staleRecords > index.count()) {
+        compact();
+    }
+    return true;
+}
+
+void AnalysisCache::close()
+{
+    flush();
+    if (mapped) {
+        file.unmap(mapped);
+        mapped = nullptr;
+    }
+    mappedSize = 0;
+    staleRecords = 0;
+    index.clear();
+    pending.clear();
+    file.close();
+    delete lock;
+    lock = nullptr;
+}
+
+void AnalysisCache::remap()
+{
+    qint64 indexedSize = mappedSize > 0 ? mappedSize : HeaderSize;
+    if (mapped) {
+        file.unmap(mapped);
+        mapped = nullptr;
+    }
+
+    mappedSize = file.size();
+    if (mappedSize <= HeaderSize) {
+        mappedSize = 0;
+        return;
+    }
+    mapped = file.map(0, mappedSize);
+    if (!mapped) {
+        mappedSize = 0;
+        return;
+    }
+
+    // Индексируются только записи после уже просмотренной части файла
+    qint64 pos = indexedSize;
+    while (pos + 4 <= mappedSize) {
+        quint32 length = qFromBigEndian<quint32>(mapped + pos);
+        if (length > quint64(mappedSize - pos - 4)) {
+            break;
+        }
+
+        QByteArray payload = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped + pos + 4), length);
+        QDataStream in(payload);
+        setStreamVersion(in);
+
+        QString path;
+        Entry entry;
+        QByteArray hash;
+        in >> path >> entry.size >> entry.modified >> hash >> entry.pixelStats;
+        if (in.status() != QDataStream::Ok) {
+            break;
+        }
+        entry.offset = pos;
+
+        if (index.contains(path)) {
+            ++staleRecords;
+        }
+        index.insert(path, entry);
+        pos += 4 + length;
+    }
+
+    // Недописанный хвост (например, после аварийного завершения) отрезается
+    if (pos < mappedSize) {
+        file.unmap(mapped);
+        file.resize(pos);
+        mappedSize = pos;
+        mapped = file.map(0, mappedSize);
+        if (!mapped) {
+            mappedSize = 0;
+        }
+    }
+}
+
+bool AnalysisCache::lookup(const QString &filePath, const CacheKey &key, const AnalysisOptions &options, ImageInfo &info) const
+{
+    auto it = index.constFind(filePath);
+    if (it == index.constEnd() || !mapped) {
+        return false;
+    }
+
+    const Entry &entry = it.value();
+    if (entry.size != key.size || entry.modified != key.modified || (options.pixelStats && !entry.pixelStats)) {
+        return false;
+    }
+
+    quint32 length = qFromBigEndian<quint32>(mapped + entry.offset);
+    QByteArray payload = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped + entry.offset + 4), length);
+    QDataStream in(payload);
+    setStreamVersion(in);
+
+    QString path;
+    qint64 size, modified;
+    QByteArray hash;
+    bool pixelStats;
+    in >> path >> size >> modified >> hash >> pixelStats;
+    if (options.hashContents && (key.hash.isEmpty() || hash != key.hash)) {
+        return false;
+    }
+
+    in >> info;
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    if (options.perceptualHash && !info.perceptualHash && info.status == ImageInfo::Ok) {
+        return false;
+    }
+
+    // Оценка по выборке не заменяет точный подсчёт и выборку большего размера
+    return !(options.pixelStats && info.sampleBudget > 0
+             && (options.sampleBudget == 0 || options.sampleBudget > info.sampleBudget));
+}
+
+void AnalysisCache::insert(const ImageInfo &info, const CacheKey &key)
+{
+    QByteArray payload;
+    {
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        setStreamVersion(out);
+        out << info.filePath << key.size << key.modified << key.hash << info.pixelStats << info;
+    }
+
+    uchar length[4];
+    qToBigEndian(quint32(payload.size()), length);
+
+    QMutexLocker locker(&pendingMutex);
+    pending.append(reinterpret_cast<const char *>(length), 4);
+    pending.append(payload);
+}
+
+ImageInfo AnalysisCache::analyze(const QString &filePath, const AnalysisOptions &options, bool *hit)
+{
+    ImageInfo info;
+    bool found;
+    CacheKey key;
+    {
+        StageTimer timer(options.profiler, AnalysisProfiler::CacheStage, filePath);
+        key = CacheKey::forFile(filePath, options.hashContents);
+        found = lookup(filePath, key, options, info);
+    }
+    if (!found) {
+        info = ImageAnalysis::analyzeFile(filePath, options);
+        insert(info, key);
+    }
+    if (hit) {
+        *hit = found;
+    }
+    return info;
+}
+
+void AnalysisCache::flush()
+{
+    if (pending.isEmpty() || !file.isOpen()) {
+        return;
+    }
+
+    file.seek(file.size());
+    file.write(pending);
+    file.flush();
+    pending.clear();
+    remap();
+}
+
+void AnalysisCache::clear()
+{
+    if (!file.isOpen()) {
+        return;
+    }
+
+    // Остаётся только заголовок; блокировка при этом не отпускается
+    if (mapped) {
+        file.unmap(mapped);
+        mapped = nullptr;
+    }
+    mappedSize = 0;
+    staleRecords = 0;
+    index.clear();
+    pending.clear();
+    file.resize(HeaderSize);
+}
+
+void AnalysisCache::compact()
+{
+    // Переписываются только последние записи каждого пути
+    QString path = file.fileName();
+    QFile compacted(path + ".tmp");
+    if (!compacted.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    compacted.write(reinterpret_cast<const char *>(mapped), HeaderSize);
+    for (const Entry &entry : std::as_const(index)) {
+        quint32 length = qFromBigEndian<quint32>(mapped + entry.offset);
+        compacted.write(reinterpret_cast<const char *>(mapped + entry.offset), 4 + qint64(length));
+    }
+    if (!compacted.flush()) {
+        compacted.close();
+        QFile::remove(path + ".tmp");
+        return;
+    }
+    compacted.close();
+
+    // Файл подменяется под нашей блокировкой: других открытых копий нет
+    file.unmap(mapped);
+    mapped = nullptr;
+    file.close();
+    QFile::remove(path);
+    QFile::rename(path + ".tmp", path);
+
+    mappedSize = 0;
+    staleRecords = 0;
+    index.clear();
+    if (!file.open(QIODevice::ReadWrite)) {
+        close();
+        return;
+    }
+    remap();
+}
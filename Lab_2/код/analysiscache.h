@@ -0,0 +1,76 @@
+#ifndef ANALYSISCACHE_H
+#define ANALYSISCACHE_H
+
+#include <QFile>
+#include <QLockFile>
+#include <QHash>
+#include <QMutex>
+#include <QByteArray>
+#include "imageanalysis.h"
+
+// Ключ записи в кэше: файл считается неизменным, пока совпадают
+// размер и время изменения (и хэш содержимого, если он запрошен)
+struct CacheKey
+{
+    qint64 size = 0;
+    qint64 modified = 0;   // мс с начала эпохи
+    QByteArray hash;       // пусто, если хэш не считался
+
+    static CacheKey forFile(const QString &filePath, bool withHash);
+};
+
+// Постоянный кэш результатов анализа. Файл только дописывается записями
+// QDataStream, при открытии отображается в память и индексируется по пути;
+// при повторной записи того же пути действует последняя запись.
+//
+// Один файл кэша общий для окна и запусков --cli, поэтому открытый кэш
+// держит блокировку <файл>.lock до close(): чужие дописывания и сжатие
+// не могут попасть под наше отображение. Второй процесс получает false
+// из open() и работает без кэша.
+class AnalysisCache
+{
+private:
+    struct Entry
+    {
+        qint64 offset;
+        qint64 size;
+        qint64 modified;
+        bool pixelStats;
+    };
+
+    QFile file;
+    QLockFile *lock;
+    uchar *mapped;
+    qint64 mappedSize;
+    int staleRecords;
+
+    QHash<QString, Entry> index;
+
+    QMutex pendingMutex;
+    QByteArray pending;
+
+    void remap();
+    void compact();
+
+public:
+    AnalysisCache();
+    ~AnalysisCache();
+
+    // По умолчанию файл лежит в QStandardPaths::CacheLocation;
+    // false, если файл не открылся или занят другим процессом
+    bool open(const QString &fileName = QString());
+    void close();
+
+    // Потокобезопасны между собой, пока не вызывается flush()
+    bool lookup(const QString &filePath, const CacheKey &key, const AnalysisOptions &options, ImageInfo &info) const;
+    void insert(const ImageInfo &info, const CacheKey &key);
+
+    // Результат из кэша, а при промахе - анализ файла и запись в кэш
+    ImageInfo analyze(const QString &filePath, const AnalysisOptions &options, bool *hit = nullptr);
+
+    // Дописывает накопленные записи в файл; только когда анализ не идёт
+    void flush();
+    void clear();
+};
+
+#endif // ANALYSISCACHE_H
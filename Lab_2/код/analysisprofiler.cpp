@@ -0,0 +1,226 @@
+#include "analysisprofiler.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <algorithm>
+
+namespace {
+
+QString formatDuration(qint64 nanoseconds)
+{
+    if (nanoseconds < 1000000) {
+        return QString("%1 мкс").arg(nanoseconds / 1000);
+    }
+    if (nanoseconds < 10000000000LL) {
+        return QString("%1 мс").arg(nanoseconds / 1e6, 0, 'f', 1);
+    }
+    return QString("%1 с").arg(nanoseconds / 1e9, 0, 'f', 1);
+}
+
+}
+
+AnalysisProfiler::AnalysisProfiler()
+{
+    reset();
+}
+
+void AnalysisProfiler::reset()
+{
+    QMutexLocker locker(&mutex);
+    for (StageStats &stage : stats) {
+        stage.count = 0;
+        stage.total = 0;
+        stage.max = 0;
+        for (std::atomic<qint64> &bucket : stage.buckets) {
+            bucket = 0;
+        }
+    }
+    events.clear();
+    slowest.clear();
+    clock.start();
+}
+
+qint64 AnalysisProfiler::now() const
+{
+    return clock.nsecsElapsed();
+}
+
+int AnalysisProfiler::bucketOf(qint64 duration)
+{
+    // Корзина i: от 2^(i-1) до 2^i мкс, в нулевой - меньше микросекунды
+    quint64 microseconds = quint64(duration / 1000);
+    if (microseconds == 0) {
+        return 0;
+    }
+    return qMin(64 - qCountLeadingZeroBits(microseconds), BucketCount - 1);
+}
+
+void AnalysisProfiler::record(Stage stage, qint64 start, qint64 duration, const QString &filePath)
+{
+    StageStats &entry = stats[stage];
+    ++entry.count;
+    entry.total += duration;
+    ++entry.buckets[bucketOf(duration)];
+    qint64 max = entry.max;
+    while (duration > max && !entry.max.compare_exchange_weak(max, duration)) {
+    }
+
+    Event event{ start, duration, quint64(quintptr(QThread::currentThreadId())), stage, filePath };
+
+    QMutexLocker locker(&mutex);
+    if (events.count() < MaxEvents) {
+        events.append(event);
+    }
+    if (stage == FileStage && (slowest.count() < SlowestCount || duration > slowest.last().duration)) {
+        int i = slowest.count();
+        while (i > 0 && slowest[i - 1].duration < duration) {
+            --i;
+        }
+        slowest.insert(i, event);
+        if (slowest.count() > SlowestCount) {
+            slowest.removeLast();
+        }
+    }
+}
+
+QString AnalysisProfiler::stageName(Stage stage)
+{
+    switch (stage) {
+    case FileStage:   return "Файл целиком";
+    case CacheStage:  return "Кэш";
+    case StatStage:   return "QFileInfo";
+    case HeaderStage: return "Заголовок";
+    case ProbeStage:  return "canRead";
+    case DecodeStage: return "Декодирование";
+    case PixelStage:  return "Пиксели";
+    case HashStage:   return "Хэши";
+    case InsertStage: return "Вставка в таблицу";
+    case TextStage:   return "Текст ячеек";
+    default:          return QString();
+    }
+}
+
+qint64 AnalysisProfiler::percentile(Stage stage, double fraction) const
+{
+    const StageStats &entry = stats[stage];
+    qint64 target = qint64(entry.count * fraction);
+    qint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += entry.buckets[i];
+        if (seen > target) {
+            return (qint64(1) << i) * 1000;
+        }
+    }
+    return entry.max;
+}
+
+QString AnalysisProfiler::summary() const
+{
+    // Доли считаются от суммы этапов; "файл целиком" их включает и не учитывается
+    qint64 sum = 0;
+    for (int stage = CacheStage; stage < StageCount; ++stage) {
+        sum += stats[stage].total;
+    }
+    if (sum == 0) {
+        return QString();
+    }
+
+    QVector<int> order;
+    for (int stage = CacheStage; stage < StageCount; ++stage) {
+        if (stats[stage].total > 0) {
+            order.append(stage);
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](int a, int b) { return stats[a].total > stats[b].total; });
+
+    QStringList parts;
+    for (int i = 0; i < qMin(3, int(order.count())); ++i) {
+        parts.append(QString("%1 %2%").arg(stageName(Stage(order[i]))).arg(stats[order[i]].total * 100 / sum));
+    }
+
+    QString text = QString("Время: %1 (%2)").arg(formatDuration(sum), parts.join(", "));
+
+    QMutexLocker locker(&mutex);
+    if (!slowest.isEmpty()) {
+        text += QString("; самый долгий файл: %1 - %2")
+                    .arg(QFileInfo(slowest.first().filePath).fileName(), formatDuration(slowest.first().duration));
+    }
+    return text;
+}
+
+QString AnalysisProfiler::details() const
+{
+    QString html = "<table><tr><th align='left'>Этап</th><th>Замеров</th><th>Среднее</th>"
+                   "<th>p50 &lt;</th><th>p99 &lt;</th><th>Максимум</th></tr>";
+    for (int i = 0; i < StageCount; ++i) {
+        Stage stage = Stage(i);
+        qint64 count = stats[stage].count;
+        if (count == 0) {
+            continue;
+        }
+        html += QString("<tr><td>%1</td><td align='right'>%2</td><td align='right'>%3</td>"
+                        "<td align='right'>%4</td><td align='right'>%5</td><td align='right'>%6</td></tr>")
+                    .arg(stageName(stage)).arg(count)
+                    .arg(formatDuration(stats[stage].total / count))
+                    .arg(formatDuration(percentile(stage, 0.5)))
+                    .arg(formatDuration(percentile(stage, 0.99)))
+                    .arg(formatDuration(stats[stage].max));
+    }
+    html += "</table>";
+
+    QMutexLocker locker(&mutex);
+    if (!slowest.isEmpty()) {
+        html += "<p><b>Самые долгие файлы</b><br>";
+        for (const Event &event : slowest) {
+            html += QString("%1 - %2<br>").arg(QFileInfo(event.filePath).fileName().toHtmlEscaped(),
+                                               formatDuration(event.duration));
+        }
+        html += "</p>";
+    }
+    return html;
+}
+
+bool AnalysisProfiler::exportTrace(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    // Формат Trace Event: события "X" с началом и длительностью в микросекундах
+    QMutexLocker locker(&mutex);
+    file.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (int i = 0; i < events.count(); ++i) {
+        const Event &event = events[i];
+        QJsonObject record;
+        record["name"] = stageName(event.stage);
+        record["cat"] = "analysis";
+        record["ph"] = "X";
+        record["ts"] = event.start / 1000.0;
+        record["dur"] = event.duration / 1000.0;
+        record["pid"] = 1;
+        record["tid"] = qint64(event.thread);
+        if (!event.filePath.isEmpty()) {
+            record["args"] = QJsonObject{ { "file", event.filePath } };
+        }
+        file.write(QJsonDocument(record).toJson(QJsonDocument::Compact));
+        file.write(i + 1 < events.count() ? ",\n" : "\n");
+    }
+    file.write("]}\n");
+    return file.error() == QFile::NoError;
+}
+
+StageTimer::StageTimer(AnalysisProfiler *profiler, AnalysisProfiler::Stage stage, const QString &filePath)
+    : profiler(profiler), stage(stage), filePath(filePath), start(profiler ? profiler->now() : 0)
+{
+}
+
+StageTimer::~StageTimer()
+{
+    if (profiler) {
+        profiler->record(stage, start, profiler->now() - start, filePath);
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef ANALYSISPROFILER_H
+#define ANALYSISPROFILER_H
+
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <atomic>
+
+// Замер времени по этапам анализа. Для каждого этапа копится гистограмма
+// длительностей по степеням двойки (в микросекундах) на атомарных
+// счётчиках, а отдельные замеры пишутся в журнал для трассировки в
+// формате Chrome (chrome://tracing, Perfetto). Пишется из любых потоков.
+class AnalysisProfiler
+{
+public:
+    enum Stage {
+        FileStage,       // файл целиком
+        CacheStage,      // поиск в кэше
+        StatStage,       // QFileInfo
+        HeaderStage,     // разбор заголовка
+        ProbeStage,      // QImageReader::canRead и формат пикселей
+        DecodeStage,     // QImageReader::read
+        PixelStage,      // статистика по пикселям
+        HashStage,       // перцептивные хэши
+        InsertStage,     // добавление пачки в таблицу
+        TextStage,       // текст ячеек таблицы
+        StageCount
+    };
+
+    static const int BucketCount = 24;   // до 2^23 мкс, около 8 с
+    static const int MaxEvents = 1000000;
+    static const int SlowestCount = 10;
+
+    AnalysisProfiler();
+
+    void reset();
+    qint64 now() const;
+    void record(Stage stage, qint64 start, qint64 duration, const QString &filePath = QString());
+
+    static QString stageName(Stage stage);
+
+    // Краткая сводка для строки состояния и подробная с гистограммами
+    QString summary() const;
+    QString details() const;
+
+    bool exportTrace(const QString &fileName) const;
+
+private:
+    struct Event
+    {
+        qint64 start;
+        qint64 duration;
+        quint64 thread;
+        Stage stage;
+        QString filePath;
+    };
+
+    struct StageStats
+    {
+        std::atomic<qint64> count;
+        std::atomic<qint64> total;
+        std::atomic<qint64> max;
+        std::atomic<qint64> buckets[BucketCount];
+    };
+
+    QElapsedTimer clock;
+    StageStats stats[StageCount];
+
+    mutable QMutex mutex;
+    QVector<Event> events;
+    QVector<Event> slowest;    // самые долгие файлы, по убыванию
+
+    static int bucketOf(qint64 duration);
+    qint64 percentile(Stage stage, double fraction) const;
+};
+
+// Замер одного этапа на время жизни объекта; без профайлера ничего не делает
+class StageTimer
+{
+public:
+    StageTimer(AnalysisProfiler *profiler, AnalysisProfiler::Stage stage, const QString &filePath = QString());
+    ~StageTimer();
+
+private:
+    AnalysisProfiler *profiler;
+    AnalysisProfiler::Stage stage;
+    QString filePath;
+    qint64 start;
+};
+
+#endif // ANALYSISPROFILER_H
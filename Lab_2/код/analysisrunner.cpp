@@ -0,0 +1,194 @@
+#include "analysisrunner.h"
+#include "analysiscache.h"
+#include <QMutexLocker>
+
+AnalysisRunner::AnalysisRunner(QObject *parent)
+    : QObject(parent), fileCount(0), nextToQueue(0), cache(nullptr), nextInOrder(0), nextToAnalyze(0),
+      activeWorkers(0), inputOpen(false), refillPosted(false), finishedCount(0), cachedCount(0),
+      cancelled(false), running(false)
+{
+    flushTimer.setInterval(50);
+    connect(&flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+AnalysisRunner::~AnalysisRunner()
+{
+    cancelled = true;
+    pool.waitForDone();
+}
+
+void AnalysisRunner::start(int count, const PathSource &pathSource, const AnalysisOptions &analysisOptions,
+                           bool moreInput)
+{
+    cancel();
+    pool.waitForDone();
+
+    source = pathSource;
+    fileCount = count;
+    nextToQueue = 0;
+    options = analysisOptions;
+    queue.clear();
+    ordered.clear();
+    outOfOrder.clear();
+    nextInOrder = 0;
+    nextToAnalyze = 0;
+    activeWorkers = 0;
+    inputOpen = moreInput;
+    refillPosted = false;
+    finishedCount = 0;
+    cachedCount = 0;
+    cancelled = false;
+    running = true;
+
+    refill();
+
+    flushTimer.start();
+    emit progress(0, fileCount);
+}
+
+void AnalysisRunner::append(int count)
+{
+    if (!running || count <= 0) {
+        return;
+    }
+    fileCount += count;
+    refill();
+}
+
+void AnalysisRunner::closeInput()
+{
+    QMutexLocker locker(&mutex);
+    inputOpen = false;
+}
+
+void AnalysisRunner::refill()
+{
+    // Пути запрашиваются без мьютекса, рабочие потоки тем временем разбирают очередь
+    int queued;
+    {
+        QMutexLocker locker(&mutex);
+        refillPosted = false;
+        queued = int(queue.count());
+    }
+    QStringList more;
+    while (queued + more.count() < QueueSize && nextToQueue < fileCount && !cancelled) {
+        more.append(source(nextToQueue++));
+    }
+    if (!more.isEmpty()) {
+        QMutexLocker locker(&mutex);
+        queue.append(more);
+    }
+    startWorkers();
+}
+
+void AnalysisRunner::startWorkers()
+{
+    // Не больше задач, чем путей в очереди: каждая задача сама забирает следующие индексы
+    int count;
+    {
+        QMutexLocker locker(&mutex);
+        count = qMin(pool.maxThreadCount() - activeWorkers, int(queue.count()));
+        activeWorkers += qMax(count, 0);
+    }
+    for (int i = 0; i < count; ++i) {
+        pool.start([this]() { work(); });
+    }
+}
+
+void AnalysisRunner::cancel()
+{
+    cancelled = true;
+}
+
+bool AnalysisRunner::isRunning() const
+{
+    return running;
+}
+
+void AnalysisRunner::setCache(AnalysisCache *analysisCache)
+{
+    cache = analysisCache;
+}
+
+int AnalysisRunner::cacheHits() const
+{
+    return cachedCount;
+}
+
+void AnalysisRunner::work()
+{
+    forever {
+        int index;
+        QString filePath;
+        {
+            // Решение о выходе принимается под тем же мьютексом, что и пополнение
+            // очереди, иначе добавленный в этот момент файл остался бы без обработчика
+            QMutexLocker locker(&mutex);
+            if (cancelled || queue.isEmpty()) {
+                --activeWorkers;
+                return;
+            }
+            index = nextToAnalyze++;
+            filePath = queue.takeFirst();
+
+            // Очередь пополняется заранее, чтобы потоки не ждали таймера
+            if (queue.count() < QueueSize / 2 && !refillPosted) {
+                refillPosted = true;
+                QMetaObject::invokeMethod(this, "refill", Qt::QueuedConnection);
+            }
+        }
+
+        ImageInfo info;
+        if (cache && options.useCache) {
+            bool hit;
+            info = cache->analyze(filePath, options, &hit);
+            if (hit) {
+                ++cachedCount;
+            }
+        } else {
+            info = ImageAnalysis::analyzeFile(filePath, options);
+        }
+
+        QMutexLocker locker(&mutex);
+        if (index != nextInOrder) {
+            outOfOrder.insert(index, std::move(info));
+        } else {
+            ordered.append(std::move(info));
+            ++nextInOrder;
+            for (auto it = outOfOrder.find(nextInOrder); it != outOfOrder.end(); it = outOfOrder.find(nextInOrder)) {
+                ordered.append(std::move(it.value()));
+                outOfOrder.erase(it);
+                ++nextInOrder;
+            }
+        }
+        ++finishedCount;
+    }
+}
+
+void AnalysisRunner::flush()
+{
+    QList<ImageInfo> batch;
+    bool done;
+    bool idle;
+    {
+        QMutexLocker locker(&mutex);
+        batch.swap(ordered);
+        done = nextInOrder >= fileCount && !inputOpen;
+        idle = activeWorkers == 0;
+    }
+
+    if (!batch.isEmpty()) {
+        emit resultsReady(batch);
+    }
+    emit progress(finishedCount, fileCount);
+
+    if (done || (cancelled && idle)) {
+        flushTimer.stop();
+        running = false;
+        source = PathSource();
+        if (cache) {
+            cache->flush();
+        }
+        emit finished(!done);
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef ANALYSISRUNNER_H
+#define ANALYSISRUNNER_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QMutex>
+#include <QTimer>
+#include <QHash>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+#include "imageanalysis.h"
+
+class AnalysisCache;
+
+// Анализ файлов в пуле потоков. Рабочие потоки берут следующий индекс
+// из общего счётчика, а результаты уходят в GUI пачками по таймеру
+// строго в порядке входного списка. Список можно дополнять во время
+// анализа, пока вход не закрыт через closeInput().
+//
+// Копии списка нет: пути берутся у вызывающего по индексу, в потоке GUI,
+// небольшой очередью впереди рабочих потоков.
+class AnalysisRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Путь по индексу входного списка; вызывается только в потоке GUI
+    typedef std::function<QString(int)> PathSource;
+
+    // Сколько путей держать в очереди впереди рабочих потоков
+    static const int QueueSize = 1024;
+
+private:
+    QThreadPool pool;
+    QTimer flushTimer;
+    PathSource source;
+    int fileCount;
+    int nextToQueue;
+    AnalysisOptions options;
+    AnalysisCache *cache;
+
+    // Всё ниже до refillPosted - под mutex. Результаты по порядку сразу идут
+    // в ordered, в outOfOrder ждут только обогнавшие, то есть не больше,
+    // чем файлов в работе
+    QMutex mutex;
+    QStringList queue;             // пути с индекса nextToAnalyze
+    QList<ImageInfo> ordered;
+    QHash<int, ImageInfo> outOfOrder;
+    int nextInOrder;
+    int nextToAnalyze;
+    int activeWorkers;
+    bool inputOpen;
+    bool refillPosted;
+
+    std::atomic<int> finishedCount;
+    std::atomic<int> cachedCount;
+    std::atomic<bool> cancelled;
+    bool running;
+
+    void work();
+    void startWorkers();
+
+public:
+    explicit AnalysisRunner(QObject *parent = nullptr);
+    ~AnalysisRunner();
+
+    void start(int count, const PathSource &source, const AnalysisOptions &options = AnalysisOptions(),
+               bool moreInput = false);
+    // Во входном списке появилось ещё count путей в конце
+    void append(int count);
+    void closeInput();
+    void cancel();
+    bool isRunning() const;
+
+    // Кэш используется, если задан и разрешён в AnalysisOptions
+    void setCache(AnalysisCache *cache);
+    int cacheHits() const;
+
+signals:
+    void resultsReady(const QList<ImageInfo> &batch);
+    void progress(int done, int total);
+    void finished(bool cancelled);
+
+private slots:
+    void flush();
+    void refill();
+};
+
+#endif // ANALYSISRUNNER_H
@@ -0,0 +1,215 @@
+#include "analyzerbenchmark.h"
+#include "analysiscache.h"
+#include "directoryscanner.h"
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QThreadPool>
+#include <QMutex>
+#include <QMutexLocker>
+#include <cstdio>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Память во время прохода замеряется с таким шагом
+const int MemorySampleMs = 10;
+
+void printLine(const QString &line)
+{
+    std::fputs(qPrintable(line), stdout);
+    std::fputc('\n', stdout);
+}
+
+}
+
+AnalyzerBenchmark::AnalyzerBenchmark(const AnalysisOptions &options, int threads)
+    : options(options), threads(threads)
+{
+}
+
+qint64 AnalyzerBenchmark::currentMemory()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return qint64(counters.WorkingSetSize);
+    }
+    return 0;
+#elif defined(Q_OS_LINUX)
+    // Второе число statm - резидентные страницы
+    long pages = 0;
+    std::FILE *statm = std::fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0;
+    }
+    if (std::fscanf(statm, "%*ld %ld", &pages) != 1) {
+        pages = 0;
+    }
+    std::fclose(statm);
+    return qint64(pages) * sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+AnalyzerBenchmark::Pass AnalyzerBenchmark::runPass(const QStringList &files, AnalysisCache *cache)
+{
+    std::atomic<int> nextIndex(0);
+    std::atomic<qint64> bytes(0);
+    std::atomic<int> cacheHits(0);
+    std::atomic<int> errors(0);
+    std::atomic<qint64> formatFiles[FormatCount] = {};
+    std::atomic<qint64> formatTime[FormatCount] = {};
+
+    auto work = [&]() {
+        QElapsedTimer timer;
+        forever {
+            int index = nextIndex++;
+            if (index >= files.count()) {
+                return;
+            }
+
+            timer.start();
+            ImageInfo info;
+            bool hit = false;
+            if (cache) {
+                info = cache->analyze(files.at(index), options, &hit);
+            } else {
+                info = ImageAnalysis::analyzeFile(files.at(index), options);
+            }
+            qint64 elapsed = timer.nsecsElapsed();
+
+            int format = info.header.format;
+            formatFiles[format] += 1;
+            formatTime[format] += elapsed;
+            bytes += info.fileSize;
+            if (hit) {
+                ++cacheHits;
+            }
+            if (info.status != ImageInfo::Ok) {
+                ++errors;
+            }
+        }
+    };
+
+    QElapsedTimer wall;
+    wall.start();
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    qint64 peak = currentMemory();
+    for (int i = 0; i < threads; ++i) {
+        pool.start(work);
+    }
+    // Пока потоки работают, текущий поток замеряет память
+    while (!pool.waitForDone(MemorySampleMs)) {
+        peak = qMax(peak, currentMemory());
+    }
+    peak = qMax(peak, currentMemory());
+
+    Pass pass;
+    pass.elapsed = wall.nsecsElapsed();
+    pass.bytes = bytes;
+    pass.cacheHits = cacheHits;
+    pass.errors = errors;
+    pass.peakMemory = peak;
+    for (int i = 0; i < FormatCount; ++i) {
+        pass.formatFiles[i] = formatFiles[i];
+        pass.formatTime[i] = formatTime[i];
+    }
+    return pass;
+}
+
+int AnalyzerBenchmark::run(const QString &folder)
+{
+    QStringList files;
+    QDirIterator it(folder, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QString path = it.next();
+        if (DirectoryScanner::isImageFile(path)) {
+            files.append(path);
+        }
+    }
+    if (files.isEmpty()) {
+        std::fprintf(stderr, "%s\n", qPrintable(QString("%1: нет файлов изображений").arg(folder)));
+        return 2;
+    }
+
+    // Кэш результатов на время замера - во временной папке, чтобы первый
+    // проход точно начинался с пустого. Файловый кэш ОС так не сбросить:
+    // для честного холодного прохода набор должен не помещаться в память
+    // или читаться после перезагрузки.
+    QTemporaryDir cacheDirectory;
+    AnalysisCache cache;
+    bool useCache = options.useCache && cacheDirectory.isValid()
+                    && cache.open(cacheDirectory.filePath("analysis.cache"));
+
+    printLine(QString("Файлов: %1, потоков: %2, статистика по пикселям: %3, кэш: %4")
+                  .arg(files.count()).arg(threads)
+                  .arg(options.pixelStats ? "да" : "нет", useCache ? "да" : "нет"));
+    // Ширина в arg() считается в символах, а не в байтах UTF-8, так что кириллица не сбивает столбцы
+    printLine(QString("%1 %2 %3 %4 %5 %6 %7")
+                  .arg("Проход", -10).arg("файлов/с", 10).arg("МБ/с", 10).arg("время, с", 10)
+                  .arg("из кэша", 10).arg("ошибок", 10).arg("пик памяти", 14));
+
+    Pass cold = runPass(files, useCache ? &cache : nullptr);
+    printPass("холодный", cold, files.count());
+
+    if (useCache) {
+        cache.flush();
+    }
+    Pass warm = runPass(files, useCache ? &cache : nullptr);
+    printPass("тёплый", warm, files.count());
+
+    printLine("\nСтоимость по форматам, холодный проход:");
+    printFormats(cold);
+    printLine("\nСтоимость по форматам, тёплый проход:");
+    printFormats(warm);
+
+    cache.close();
+    std::fflush(stdout);
+    return 0;
+}
+
+void AnalyzerBenchmark::printPass(const char *name, const Pass &pass, int fileCount) const
+{
+    double seconds = pass.elapsed / 1e9;
+    printLine(QString("%1 %2 %3 %4 %5 %6 %7")
+                  .arg(QString(name), -10)
+                  .arg(seconds > 0 ? fileCount / seconds : 0.0, 10, 'f', 0)
+                  .arg(seconds > 0 ? pass.bytes / 1048576.0 / seconds : 0.0, 10, 'f', 1)
+                  .arg(seconds, 10, 'f', 2)
+                  .arg(pass.cacheHits, 10)
+                  .arg(pass.errors, 10)
+                  .arg(QString("%1 МБ").arg(pass.peakMemory / 1048576.0, 0, 'f', 1), 14));
+}
+
+void AnalyzerBenchmark::printFormats(const Pass &pass) const
+{
+    // Время по форматам - суммарное по потокам, поэтому больше времени прохода
+    qint64 total = 0;
+    for (qint64 time : pass.formatTime) {
+        total += time;
+    }
+
+    printLine(QString("%1 %2 %3 %4").arg("Формат", -10).arg("файлов", 10).arg("среднее, мкс", 14).arg("доля, %", 10));
+    for (int format = 0; format < FormatCount; ++format) {
+        qint64 count = pass.formatFiles[format];
+        if (count == 0) {
+            continue;
+        }
+        QString name = format == ImageHeader::Unknown ? QString("другие")
+                                                      : QString(ImageHeaders::formatName(ImageHeader::Format(format)));
+        printLine(QString("%1 %2 %3 %4")
+                      .arg(name, -10)
+                      .arg(count, 10)
+                      .arg(pass.formatTime[format] / 1e3 / count, 14, 'f', 1)
+                      .arg(total > 0 ? pass.formatTime[format] * 100.0 / total : 0.0, 10, 'f', 1));
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef ANALYZERBENCHMARK_H
+#define ANALYZERBENCHMARK_H
+
+#include <QStringList>
+#include <atomic>
+#include "imageanalysis.h"
+
+class AnalysisCache;
+
+// Замер скорости анализа на наборе файлов без окна. Два прохода по
+// одному списку: с пустым кэшем результатов (во временной папке) и с
+// заполненным. Отчёт в stdout: файлов и мегабайт в секунду, пиковый
+// объём памяти за каждый проход и стоимость анализа по форматам.
+class AnalyzerBenchmark
+{
+public:
+    AnalyzerBenchmark(const AnalysisOptions &options, int threads);
+
+    int run(const QString &folder);
+
+private:
+    static const int FormatCount = ImageHeader::Pcx + 1;
+
+    struct Pass
+    {
+        qint64 elapsed = 0;     // нс
+        qint64 bytes = 0;
+        int cacheHits = 0;
+        int errors = 0;
+        qint64 peakMemory = 0;  // байт, наибольший замер во время прохода
+        qint64 formatFiles[FormatCount] = {};
+        qint64 formatTime[FormatCount] = {};
+    };
+
+    AnalysisOptions options;
+    int threads;
+
+    Pass runPass(const QStringList &files, AnalysisCache *cache);
+    void printPass(const char *name, const Pass &pass, int fileCount) const;
+    void printFormats(const Pass &pass) const;
+
+    // Текущий объём резидентной памяти процесса; 0, если узнать нельзя.
+    // Пик за всё время процесса не подходит: тёплый проход никогда не
+    // покажет меньше холодного
+    static qint64 currentMemory();
+};
+
+#endif // ANALYZERBENCHMARK_H
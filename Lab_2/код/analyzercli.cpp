@@ -0,0 +1,425 @@
+#include "analyzercli.h"
+#include "directoryscanner.h"
+#include "corpusgenerator.h"
+#include "analyzerbenchmark.h"
+#include <QCommandLineParser>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <QThread>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+// Кэш дописывается на диск пачками, пока пул остановлен
+const qint64 CacheFlushInterval = 10000;
+
+void printError(const QString &message)
+{
+    std::fputs(qPrintable(message), stderr);
+    std::fputc('\n', stderr);
+}
+
+const char *statusName(ImageInfo::Status status)
+{
+    switch (status) {
+    case ImageInfo::ReadError: return "read_error";
+    case ImageInfo::LoadError: return "load_error";
+    default:                   return "ok";
+    }
+}
+
+QByteArray csvField(const QString &value)
+{
+    QByteArray utf8 = value.toUtf8();
+    if (!utf8.contains(',') && !utf8.contains('"') && !utf8.contains('\n')) {
+        return utf8;
+    }
+    return '"' + utf8.replace("\"", "\"\"") + '"';
+}
+
+QByteArray hashName(quint64 hash)
+{
+    return QByteArray::number(hash, 16).rightJustified(16, '0');
+}
+
+QByteArray colorName(QRgb color)
+{
+    return '#' + QByteArray::number(color & 0xFFFFFF, 16).rightJustified(6, '0');
+}
+
+}
+
+AnalyzerCli::AnalyzerCli()
+    : outputFormat(Json), cacheOpen(false), analyzedCount(0), errorCount(0), submittedCount(0)
+{
+}
+
+bool AnalyzerCli::isRequested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--cli") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int AnalyzerCli::run(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Анализ графических файлов без окна. "
+                                     "Для каждого файла в stdout выводится одна запись JSON или CSV.");
+    parser.addHelpOption();
+
+    QCommandLineOption cliOption("cli", "Запуск без графического интерфейса.");
+    QCommandLineOption formatOption("format", "Формат вывода: json или csv.", "format", "json");
+    QCommandLineOption listOption("files-from", "Файл со списком путей по одному в строке, '-' - stdin.", "list");
+    QCommandLineOption pixelStatsOption("pixel-stats", "Полностью декодировать изображения для статистики по пикселям.");
+    QCommandLineOption sampleOption("sample", "Оценивать статистику крупных несжатых изображений по выборке из N пикселей.", "pixels", "0");
+    QCommandLineOption perceptualHashOption("perceptual-hash", "Считать dHash и pHash для поиска похожих изображений.");
+    QCommandLineOption noCacheOption("no-cache", "Не использовать кэш результатов.");
+    QCommandLineOption hashOption("verify-hash", "Сверять с кэшем ещё и хэш содержимого.");
+    QCommandLineOption traceOption("trace", "Замерить время этапов и сохранить трассировку Chrome в файл.", "file");
+    QCommandLineOption generateOption("generate-corpus", "Создать синтетический набор изображений в папке.", "folder");
+    QCommandLineOption countOption("count", "Число файлов для --generate-corpus.", "count", "10000");
+    QCommandLineOption seedOption("seed", "Начальное значение генератора для --generate-corpus.", "seed", "1");
+    QCommandLineOption benchmarkOption("benchmark", "Замерить скорость анализа файлов папки.", "folder");
+    QCommandLineOption threadsOption("threads", "Число рабочих потоков.", "count", QString::number(QThread::idealThreadCount()));
+
+    parser.addOptions({ cliOption, formatOption, listOption, pixelStatsOption, sampleOption, perceptualHashOption, noCacheOption,
+                        hashOption, traceOption, generateOption, countOption, seedOption, benchmarkOption, threadsOption });
+    parser.addPositionalArgument("paths", "Файлы и папки (папки обходятся рекурсивно).", "[paths...]");
+    parser.process(arguments);
+
+    QString format = parser.value(formatOption).toLower();
+    if (format == "json") {
+        outputFormat = Json;
+    } else if (format == "csv") {
+        outputFormat = Csv;
+    } else {
+        printError("Неизвестный формат вывода, ожидается json или csv");
+        return 2;
+    }
+
+    int threads = qMax(parser.value(threadsOption).toInt(), 1);
+
+    if (parser.isSet(generateOption)) {
+        CorpusGenerator generator(parser.value(generateOption), parser.value(seedOption).toUInt());
+        bool ok = generator.generate(parser.value(countOption).toLongLong(), threads);
+        printError(QString("Создано файлов: %1, %2 МБ")
+                       .arg(generator.generatedFiles()).arg(generator.generatedBytes() / 1048576.0, 0, 'f', 1));
+        return ok ? 0 : 1;
+    }
+
+    QStringList paths = parser.positionalArguments();
+    if (paths.isEmpty() && !parser.isSet(listOption) && !parser.isSet(benchmarkOption)) {
+        printError("Не заданы файлы или папки для анализа");
+        return 2;
+    }
+
+    options.pixelStats = parser.isSet(pixelStatsOption);
+    options.sampleBudget = qMax(parser.value(sampleOption).toInt(), 0);
+    options.perceptualHash = parser.isSet(perceptualHashOption);
+    options.useCache = !parser.isSet(noCacheOption);
+    options.hashContents = parser.isSet(hashOption);
+    if (parser.isSet(traceOption)) {
+        options.profiler = &profiler;
+    }
+
+    if (parser.isSet(benchmarkOption)) {
+        AnalyzerBenchmark benchmark(options, threads);
+        int result = benchmark.run(parser.value(benchmarkOption));
+        if (options.profiler && !profiler.exportTrace(parser.value(traceOption))) {
+            printError(QString("%1: не удалось сохранить трассировку").arg(parser.value(traceOption)));
+        }
+        return result;
+    }
+
+    if (options.useCache) {
+        cacheOpen = cache.open();
+        if (!cacheOpen) {
+            printError("Кэш занят другим процессом или недоступен, анализ без кэша");
+        }
+    }
+
+    // Не больше нескольких файлов на поток в работе одновременно
+    pool.setMaxThreadCount(threads);
+    inFlight.release(threads * 4);
+
+    if (!output.open(stdout, QIODevice::WriteOnly)) {
+        printError("Не удалось открыть stdout");
+        return 2;
+    }
+    if (outputFormat == Csv) {
+        output.write(csvHeader());
+    }
+
+    bool ok = true;
+    if (parser.isSet(listOption)) {
+        ok = submitList(parser.value(listOption));
+    }
+    for (const QString &path : paths) {
+        QFileInfo fileInfo(path);
+        if (fileInfo.isDir()) {
+            submitDirectory(path);
+        } else if (fileInfo.exists()) {
+            submit(fileInfo.absoluteFilePath());
+        } else {
+            printError(QString("%1: файл не найден").arg(path));
+            ok = false;
+        }
+    }
+
+    pool.waitForDone();
+    if (cacheOpen) {
+        cache.flush();
+    }
+    output.flush();
+
+    printError(QString("Обработано файлов: %1, с ошибками: %2").arg(analyzedCount).arg(errorCount));
+    if (options.profiler) {
+        printError(profiler.summary());
+        if (!profiler.exportTrace(parser.value(traceOption))) {
+            printError(QString("%1: не удалось сохранить трассировку").arg(parser.value(traceOption)));
+            ok = false;
+        }
+    }
+    return (ok && errorCount == 0) ? 0 : 1;
+}
+
+void AnalyzerCli::submit(const QString &filePath)
+{
+    // Кэш копит новые записи в памяти; сбрасываются они только при пустом пуле
+    if (cacheOpen && ++submittedCount % CacheFlushInterval == 0) {
+        pool.waitForDone();
+        cache.flush();
+    }
+
+    inFlight.acquire();
+    pool.start([this, filePath]() {
+        analyze(filePath);
+        inFlight.release();
+    });
+}
+
+void AnalyzerCli::analyze(const QString &filePath)
+{
+    ImageInfo info = cacheOpen ? cache.analyze(filePath, options)
+                               : ImageAnalysis::analyzeFile(filePath, options);
+
+    QByteArray record = formatRecord(info);
+    ++analyzedCount;
+    if (info.status != ImageInfo::Ok) {
+        ++errorCount;
+    }
+
+    QMutexLocker locker(&outputMutex);
+    output.write(record);
+    output.flush();
+}
+
+void AnalyzerCli::submitDirectory(const QString &folder)
+{
+    QDirIterator it(folder, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QString path = it.next();
+        if (DirectoryScanner::isImageFile(path)) {
+            submit(path);
+        }
+    }
+}
+
+bool AnalyzerCli::submitList(const QString &listName)
+{
+    QFile list;
+    bool opened;
+    if (listName == "-") {
+        opened = list.open(stdin, QIODevice::ReadOnly | QIODevice::Text);
+    } else {
+        list.setFileName(listName);
+        opened = list.open(QIODevice::ReadOnly | QIODevice::Text);
+    }
+    if (!opened) {
+        printError(QString("%1: %2").arg(listName, list.errorString()));
+        return false;
+    }
+
+    // Список читается построчно, целиком в память не загружается
+    while (!list.atEnd()) {
+        QString path = QString::fromUtf8(list.readLine()).trimmed();
+        if (!path.isEmpty()) {
+            submit(path);
+        }
+    }
+    return true;
+}
+
+QByteArray AnalyzerCli::csvHeader()
+{
+    return "path,status,format,suffix,format_mismatch,width,height,dpi,depth,colors,frames,duration_ms,"
+           "alpha,grayscale,animated,compression,interlaced,progressive,unique_colors,effective_bits,sampled_pixels,"
+           "mean_color,dominant_colors,d_hash,p_hash,jpeg_quality,chroma_subsampling,png_ratio,png_wasted_bytes,camera,capture_time,orientation,file_size\n";
+}
+
+QByteArray AnalyzerCli::formatRecord(const ImageInfo &info) const
+{
+    const ImageHeader &header = info.header;
+    const char *compression = header.format == ImageHeader::Unknown ? "" : ImageHeaders::compressionName(header.compression);
+
+    if (outputFormat == Csv) {
+        QByteArray line;
+        line += csvField(info.filePath) + ',';
+        line += QByteArray(statusName(info.status)) + ',';
+        line += csvField(info.actualFormat) + ',';
+        line += csvField(info.format) + ',';
+        line += QByteArray::number(int(info.formatMismatch)) + ',';
+        line += QByteArray::number(info.size.width()) + ',';
+        line += QByteArray::number(info.size.height()) + ',';
+        line += QByteArray::number(info.dpi) + ',';
+        line += QByteArray::number(info.depth) + ',';
+        line += QByteArray::number(info.colorCount) + ',';
+        line += QByteArray::number(info.frameCount) + ',';
+        line += QByteArray::number(info.animation.duration) + ',';
+        line += QByteArray::number(int(info.hasAlpha)) + ',';
+        line += QByteArray::number(int(info.grayscale)) + ',';
+        line += QByteArray::number(int(info.animated)) + ',';
+        line += QByteArray(compression) + ',';
+        line += QByteArray::number(int(header.interlaced)) + ',';
+        line += QByteArray::number(int(header.progressive)) + ',';
+        line += QByteArray::number(info.uniqueColors) + ',';
+        line += QByteArray::number(info.effectiveBits) + ',';
+        line += QByteArray::number(info.sampledPixels) + ',';
+        // Основные цвета одним полем: "#rrggbb:доля;..."
+        const ColorSummary &colors = info.colors;
+        line += (colors.isNull() ? QByteArray() : colorName(colors.mean)) + ',';
+        for (int i = 0; i < colors.dominant.size(); ++i) {
+            line += (i > 0 ? ";" : "") + colorName(colors.dominant[i]) + ':' + QByteArray::number(colors.dominantShares[i]);
+        }
+        line += ',';
+        line += (info.perceptualHash ? hashName(info.dHash) : QByteArray()) + ',';
+        line += (info.perceptualHash ? hashName(info.pHash) : QByteArray()) + ',';
+        line += QByteArray::number(header.quality) + ',';
+        line += QByteArray(ImageHeaders::subsamplingName(header.chromaSubsampling)) + ',';
+        line += (info.png.isNull() ? QByteArray() : QByteArray::number(info.png.compressionRatio(), 'f', 2)) + ',';
+        line += (info.png.isNull() ? QByteArray() : QByteArray::number(info.png.wastedSize())) + ',';
+        const ImageMetadata &metadata = info.metadata;
+        line += csvField(metadata.camera()) + ',';
+        line += metadata.captureTime.toString(Qt::ISODate).toLatin1() + ',';
+        line += QByteArray::number(metadata.orientation) + ',';
+        line += QByteArray::number(info.fileSize) + '\n';
+        return line;
+    }
+
+    QJsonObject record;
+    record["path"] = info.filePath;
+    record["status"] = statusName(info.status);
+    record["format"] = info.actualFormat;
+    record["suffix"] = info.format;
+    record["formatMismatch"] = info.formatMismatch;
+    record["width"] = info.size.width();
+    record["height"] = info.size.height();
+    record["dpi"] = info.dpi;
+    record["depth"] = info.depth;
+    record["colors"] = info.colorCount;
+    record["frames"] = info.frameCount;
+    if (!info.animation.isNull()) {
+        const FrameSummary &animation = info.animation;
+        record["durationMs"] = animation.duration;
+        record["loopCount"] = animation.loopCount;
+        record["localPalettes"] = animation.localPalettes;
+        record["partialFrames"] = animation.partialFrames;
+        record["reducedPages"] = animation.reducedPages;
+    }
+    record["alpha"] = info.hasAlpha;
+    record["grayscale"] = info.grayscale;
+    record["animated"] = info.animated;
+    record["compression"] = compression;
+    record["interlaced"] = header.interlaced;
+    record["progressive"] = header.progressive;
+    if (header.quality > 0) {
+        record["jpegQuality"] = header.quality;
+        record["jpegQualityExact"] = header.qualityExact;
+        record["chromaSubsampling"] = ImageHeaders::subsamplingName(header.chromaSubsampling);
+        record["optimizedHuffman"] = header.optimizedHuffman;
+    }
+    if (info.pixelStats) {
+        record["uniqueColors"] = info.uniqueColors;
+        record["effectiveBits"] = info.effectiveBits;
+    }
+    if (!info.colors.isNull()) {
+        const ColorSummary &colors = info.colors;
+        QJsonArray dominant;
+        for (int i = 0; i < colors.dominant.size(); ++i) {
+            QJsonObject color;
+            color["color"] = QString::fromLatin1(colorName(colors.dominant[i]));
+            color["share"] = int(colors.dominantShares[i]);
+            dominant.append(color);
+        }
+        QJsonArray hues;
+        for (quint8 share : colors.hueHistogram) {
+            hues.append(int(share));
+        }
+        record["meanColor"] = QString::fromLatin1(colorName(colors.mean));
+        record["dominantColors"] = dominant;
+        record["hueHistogram"] = hues;
+    }
+    if (info.perceptualHash) {
+        record["dHash"] = QString::fromLatin1(hashName(info.dHash));
+        record["pHash"] = QString::fromLatin1(hashName(info.pHash));
+    }
+    if (!info.png.isNull()) {
+        const PngInfo &png = info.png;
+        QJsonObject chunks;
+        chunks["bitDepth"] = png.bitDepth;
+        chunks["colorType"] = png.colorType;
+        chunks["idatCount"] = png.idatCount;
+        chunks["idatSize"] = png.idatSize;
+        chunks["rawSize"] = png.rawSize;
+        chunks["compressionRatio"] = png.compressionRatio();
+        if (png.gamma > 0) {
+            chunks["gamma"] = png.gamma / 100000.0;
+        }
+        chunks["iccProfile"] = bool(png.chunks & PngInfo::IccProfile);
+        chunks["physicalSize"] = bool(png.chunks & PngInfo::PhysicalSize);
+        chunks["metadataSize"] = png.metadataSize;
+        chunks["trailingSize"] = png.trailingSize;
+        record["png"] = chunks;
+    }
+    if (!info.metadata.isNull()) {
+        const ImageMetadata &metadata = info.metadata;
+        QJsonObject exif;
+        if (!metadata.camera().isEmpty()) {
+            exif["camera"] = metadata.camera();
+        }
+        if (metadata.captureTime.isValid()) {
+            exif["captureTime"] = metadata.captureTime.toString(Qt::ISODate);
+        }
+        if (metadata.orientation > 0) {
+            exif["orientation"] = metadata.orientation;
+        }
+        if (metadata.thumbnailSize > 0) {
+            exif["thumbnailOffset"] = metadata.thumbnailOffset;
+            exif["thumbnailSize"] = metadata.thumbnailSize;
+            exif["thumbnailWidth"] = metadata.thumbnailWidth;
+            exif["thumbnailHeight"] = metadata.thumbnailHeight;
+        }
+        exif["exifSize"] = metadata.exifSize;
+        exif["xmpSize"] = metadata.xmpSize;
+        exif["iccSize"] = metadata.iccSize;
+        if (!metadata.iccDescription.isEmpty()) {
+            exif["iccDescription"] = metadata.iccDescription;
+        }
+        record["metadata"] = exif;
+    }
+    if (info.sampledPixels > 0) {
+        record["sampledPixels"] = info.sampledPixels;
+        record["uniqueColorsError"] = info.uniqueColorsError;
+    }
+    record["fileSize"] = info.fileSize;
+    return QJsonDocument(record).toJson(QJsonDocument::Compact) + '\n';
+}
@@ -0,0 +1,56 @@
+#ifndef ANALYZERCLI_H
+#define ANALYZERCLI_H
+
+#include <QStringList>
+#include <QFile>
+#include <QMutex>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <atomic>
+#include "imageanalysis.h"
+#include "analysiscache.h"
+#include "analysisprofiler.h"
+
+// Анализ без окна, для серверов без дисплея:
+//   image_analyzer --cli [--format json|csv] [--files-from list] [папки и файлы...]
+//   image_analyzer --cli --generate-corpus папка [--count N]
+//   image_analyzer --cli --benchmark папка [--pixel-stats]
+// Папки обходятся рекурсивно, по одной записи на файл выводится в stdout
+// по мере готовности. Число файлов в работе ограничено, поэтому память
+// не зависит от количества файлов.
+class AnalyzerCli
+{
+public:
+    enum OutputFormat { Json, Csv };
+
+    AnalyzerCli();
+
+    static bool isRequested(int argc, char *argv[]);
+    int run(const QStringList &arguments);
+
+private:
+    OutputFormat outputFormat;
+    AnalysisOptions options;
+    QThreadPool pool;
+    QSemaphore inFlight;
+    AnalysisCache cache;
+    bool cacheOpen;
+    AnalysisProfiler profiler;
+
+    QMutex outputMutex;
+    QFile output;
+
+    std::atomic<qint64> analyzedCount;
+    std::atomic<qint64> errorCount;
+    qint64 submittedCount;
+
+    void submit(const QString &filePath);
+    void analyze(const QString &filePath);
+    void submitDirectory(const QString &folder);
+    bool submitList(const QString &listName);
+
+    QByteArray formatRecord(const ImageInfo &info) const;
+    static QByteArray csvHeader();
+};
+
+#endif // ANALYZERCLI_H
@@ -0,0 +1,346 @@
+#include "colorsummary.h"
+#include "../../Lab_1/код/colorkernels.h"
+#include <QImage>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const int CellBits = 5;
+const int CellCount = 1 << (3 * CellBits);
+
+// Полосы строк меньше этого числа пикселей считаются в текущем потоке
+const qint64 BandPixels = 1 << 19;
+
+// Порог насыщенности и яркости (0-100), ниже которого у пикселя нет тона
+const double MinChroma = 20;
+
+// Линейный свет 8-битного кода sRGB в 16-битной фиксированной точке:
+// суммы по изображению остаются целыми и не зависят от порядка полос
+const quint32 *linearTable()
+{
+    static const struct Table {
+        quint32 values[256];
+        Table()
+        {
+            for (int i = 0; i < 256; ++i) {
+                values[i] = quint32(std::lround(ColorKernels::srgbToLinear(i / 255.0) * 65535));
+            }
+        }
+    } table;
+    return table.values;
+}
+
+int cellOf(QRgb color)
+{
+    return ((qRed(color) >> 3) << 10) | ((qGreen(color) >> 3) << 5) | (qBlue(color) >> 3);
+}
+
+// Представитель ячейки: 5 бит растягиваются на 8, чтобы чёрный и белый остались точными
+RGB cellColor(int cell)
+{
+    auto expand = [](int value) { return (value << 3) | (value >> 2); };
+    return RGB(expand(cell >> 10), expand((cell >> 5) & 31), expand(cell & 31));
+}
+
+int cellChannel(int cell, int channel)
+{
+    return (cell >> (10 - 5 * channel)) & 31;
+}
+
+struct Band
+{
+    quint64 linear[3] = {};
+    quint64 count = 0;
+    QVector<quint32> cells = QVector<quint32>(CellCount, 0);
+
+    void add(QRgb color, quint64 weight)
+    {
+        const quint32 *lut = linearTable();
+        linear[0] += lut[qRed(color)] * weight;
+        linear[1] += lut[qGreen(color)] * weight;
+        linear[2] += lut[qBlue(color)] * weight;
+        count += weight;
+        cells[cellOf(color)] += quint32(weight);
+    }
+};
+
+void accumulate(const QRgb *pixels, int width, int top, int bottom, qsizetype stride, bool hasAlpha, Band &band)
+{
+    const quint32 *lut = linearTable();
+    quint32 *cells = band.cells.data();
+    for (int y = top; y < bottom; ++y) {
+        const QRgb *line = pixels + y * stride;
+        quint64 r = 0, g = 0, b = 0;
+        int count = 0;
+        for (int x = 0; x < width; ++x) {
+            QRgb color = line[x];
+            if (hasAlpha && qAlpha(color) == 0) {
+                continue;
+            }
+            r += lut[qRed(color)];
+            g += lut[qGreen(color)];
+            b += lut[qBlue(color)];
+            ++count;
+            ++cells[cellOf(color)];
+        }
+        band.linear[0] += r;
+        band.linear[1] += g;
+        band.linear[2] += b;
+        band.count += count;
+    }
+}
+
+struct Box
+{
+    QVector<int> cells;
+    quint64 weight = 0;
+    int channel = 0;   // канал с наибольшим разбросом
+    int range = 0;     // разброс по нему в ячейках
+};
+
+Box makeBox(QVector<int> cells, const quint32 *counts)
+{
+    Box box;
+    box.cells = std::move(cells);
+    int low[3] = { 31, 31, 31 };
+    int high[3] = { 0, 0, 0 };
+    for (int cell : box.cells) {
+        box.weight += counts[cell];
+        for (int c = 0; c < 3; ++c) {
+            low[c] = qMin(low[c], cellChannel(cell, c));
+            high[c] = qMax(high[c], cellChannel(cell, c));
+        }
+    }
+    for (int c = 0; c < 3; ++c) {
+        if (high[c] - low[c] > box.range) {
+            box.range = high[c] - low[c];
+            box.channel = c;
+        }
+    }
+    return box;
+}
+
+// Медианное сечение: каждый раз делится группа с наибольшим весом с
+// учётом разброса, чтобы крупный однотонный фон не съедал все цвета
+QVector<Box> medianCut(const quint32 *counts)
+{
+    QVector<int> used;
+    for (int cell = 0; cell < CellCount; ++cell) {
+        if (counts[cell]) {
+            used.append(cell);
+        }
+    }
+
+    QVector<Box> boxes;
+    boxes.append(makeBox(used, counts));
+    while (boxes.size() < ColorSummary::MaxDominant) {
+        int best = -1;
+        double bestScore = 0;
+        for (int i = 0; i < boxes.size(); ++i) {
+            double score = double(boxes[i].weight) * boxes[i].range;
+            if (score > bestScore) {
+                bestScore = score;
+                best = i;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+
+        Box box = boxes.takeAt(best);
+        int channel = box.channel;
+        std::sort(box.cells.begin(), box.cells.end(), [channel](int a, int b) {
+            return cellChannel(a, channel) < cellChannel(b, channel);
+        });
+
+        // Граница по медиане веса, но обе половины непустые
+        quint64 half = box.weight / 2;
+        quint64 sum = 0;
+        qsizetype split = 1;
+        for (; split < box.cells.size() - 1; ++split) {
+            sum += counts[box.cells[split - 1]];
+            if (sum >= half) {
+                break;
+            }
+        }
+        // Ячейки с одинаковым значением канала не разрываются
+        int edge = cellChannel(box.cells[split - 1], channel);
+        while (split < box.cells.size() && cellChannel(box.cells[split], channel) == edge) {
+            ++split;
+        }
+        if (split == box.cells.size()) {
+            while (split > 1 && cellChannel(box.cells[split - 1], channel) == cellChannel(box.cells.last(), channel)) {
+                --split;
+            }
+        }
+
+        boxes.append(makeBox(box.cells.mid(0, split), counts));
+        boxes.append(makeBox(box.cells.mid(split), counts));
+    }
+    return boxes;
+}
+
+int percent(quint64 part, quint64 total)
+{
+    return total ? int((part * 100 + total / 2) / total) : 0;
+}
+
+int toSrgb(double linear)
+{
+    return qBound(0, int(std::lround(ColorKernels::linearToSrgb(linear) * 255)), 255);
+}
+
+ColorSummary summarize(const Band &band)
+{
+    ColorSummary summary;
+    if (band.count == 0) {
+        return summary;
+    }
+
+    double scale = 65535.0 * band.count;
+    summary.mean = qRgb(toSrgb(band.linear[0] / scale), toSrgb(band.linear[1] / scale), toSrgb(band.linear[2] / scale));
+
+    const quint32 *counts = band.cells.constData();
+    quint64 hues[ColorSummary::HueBins] = {};
+    for (int cell = 0; cell < CellCount; ++cell) {
+        if (!counts[cell]) {
+            continue;
+        }
+        HSV hsv = ColorKernels::rgbToHsv(cellColor(cell));
+        if (hsv.s >= MinChroma && hsv.v >= MinChroma) {
+            hues[int(hsv.h / (360 / ColorSummary::HueBins)) % ColorSummary::HueBins] += counts[cell];
+        }
+    }
+    for (int i = 0; i < ColorSummary::HueBins; ++i) {
+        summary.hueHistogram[i] = quint8(percent(hues[i], band.count));
+    }
+
+    // Цвет группы - среднее её ячеек, тоже в линейном свете
+    QVector<Box> boxes = medianCut(counts);
+    std::sort(boxes.begin(), boxes.end(), [](const Box &a, const Box &b) { return a.weight > b.weight; });
+    for (const Box &box : boxes) {
+        double linear[3] = {};
+        for (int cell : box.cells) {
+            RGB color = cellColor(cell);
+            linear[0] += ColorKernels::srgbToLinear(color.r / 255.0) * counts[cell];
+            linear[1] += ColorKernels::srgbToLinear(color.g / 255.0) * counts[cell];
+            linear[2] += ColorKernels::srgbToLinear(color.b / 255.0) * counts[cell];
+        }
+        double weight = double(box.weight);
+        summary.dominant.append(qRgb(toSrgb(linear[0] / weight), toSrgb(linear[1] / weight), toSrgb(linear[2] / weight)));
+        summary.dominantShares.append(quint8(percent(box.weight, band.count)));
+    }
+    return summary;
+}
+
+// Цвета палитры с весом по числу пикселей каждого индекса
+ColorSummary summarizeIndexed(const uchar *indices, int width, int height, qsizetype stride,
+                              const QRgb *palette, int paletteSize)
+{
+    quint64 counts[256] = {};
+    for (int y = 0; y < height; ++y) {
+        const uchar *line = indices + y * stride;
+        for (int x = 0; x < width; ++x) {
+            ++counts[line[x]];
+        }
+    }
+
+    Band band;
+    for (int i = 0; i < qMin(paletteSize, 256); ++i) {
+        if (counts[i] && qAlpha(palette[i]) != 0) {
+            band.add(palette[i], counts[i]);
+        }
+    }
+    return summarize(band);
+}
+
+}
+
+int ColorSummary::dominantHue() const
+{
+    int best = -1;
+    for (int i = 0; i < HueBins; ++i) {
+        if (hueHistogram[i] > 0 && (best < 0 || hueHistogram[i] > hueHistogram[best])) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+ColorSummary ColorSummary::computeArgb(const QRgb *pixels, int width, int height, qsizetype stride, bool hasAlpha)
+{
+    if (width <= 0 || height <= 0) {
+        return ColorSummary();
+    }
+
+    // Одна полоса на поток, но не мельче BandPixels
+    QThreadPool *pool = QThreadPool::globalInstance();
+    int count = int(qBound(qint64(1), qint64(width) * height / BandPixels, qint64(pool->maxThreadCount())));
+    count = qMin(count, height);
+
+    QVector<Band> bands(count);
+    QSemaphore done;
+    auto work = [&, pixels](int i) {
+        int top = int(qint64(i) * height / count);
+        int bottom = int(qint64(i + 1) * height / count);
+        accumulate(pixels, width, top, bottom, stride, hasAlpha, bands[i]);
+        done.release();
+    };
+
+    // Если свободных потоков нет (пул занят другими изображениями), полоса считается здесь же
+    for (int i = 1; i < count; ++i) {
+        if (!pool->tryStart([&work, i]() { work(i); })) {
+            work(i);
+        }
+    }
+    work(0);
+    done.acquire(count);
+
+    Band &total = bands[0];
+    for (int i = 1; i < count; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            total.linear[c] += bands[i].linear[c];
+        }
+        total.count += bands[i].count;
+        for (int cell = 0; cell < CellCount; ++cell) {
+            total.cells[cell] += bands[i].cells[cell];
+        }
+    }
+    return summarize(total);
+}
+
+ColorSummary ColorSummary::compute(const QImage &image)
+{
+    switch (image.format()) {
+    case QImage::Format_Indexed8: {
+        QList<QRgb> palette = image.colorTable();
+        return summarizeIndexed(image.constBits(), image.width(), image.height(), image.bytesPerLine(),
+                                palette.constData(), int(palette.size()));
+    }
+    case QImage::Format_Grayscale8: {
+        static const QList<QRgb> ramp = [] {
+            QList<QRgb> colors(256);
+            for (int i = 0; i < 256; ++i) {
+                colors[i] = qRgb(i, i, i);
+            }
+            return colors;
+        }();
+        return summarizeIndexed(image.constBits(), image.width(), image.height(), image.bytesPerLine(),
+                                ramp.constData(), 256);
+    }
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+        return computeArgb(reinterpret_cast<const QRgb *>(image.constBits()), image.width(), image.height(),
+                           image.bytesPerLine() / 4, image.format() == QImage::Format_ARGB32);
+    default:
+        break;
+    }
+
+    if (image.depth() < 8) {
+        return compute(image.convertToFormat(QImage::Format_Indexed8));
+    }
+    return compute(image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32));
+}
@@ -0,0 +1,37 @@
+#ifndef COLORSUMMARY_H
+#define COLORSUMMARY_H
+
+#include <QtGlobal>
+#include <QRgb>
+#include <QVector>
+
+class QImage;
+
+// Средний цвет, распределение тонов и основные цвета изображения.
+// Среднее считается в линейном свете (гамма sRGB из rgbToXyz в Lab_1),
+// иначе смесь чёрного с белым давала бы 128, а не 188.
+// Тон и основные цвета берутся из гистограммы на 32768 ячеек (5 бит на
+// канал): HSV считается один раз на непустую ячейку, медианное сечение
+// делит ячейки, а не пиксели. Большие изображения делятся на полосы
+// строк, которые считаются параллельно в глобальном пуле потоков.
+struct ColorSummary
+{
+    enum { HueBins = 12, MaxDominant = 5 };
+
+    QRgb mean = 0;
+    quint8 hueHistogram[HueBins] = {};  // проценты пикселей по секторам тона в 30°, без ненасыщенных
+    QVector<QRgb> dominant;             // по убыванию доли, пусто - не посчитано
+    QVector<quint8> dominantShares;     // доли в процентах
+
+    bool isNull() const { return dominant.isEmpty(); }
+
+    // Сектор тона с наибольшей долей или -1, если изображение почти без цвета
+    int dominantHue() const;
+
+    static ColorSummary compute(const QImage &image);
+
+    // Пиксели 0xAARRGGBB, stride - в пикселях; с hasAlpha полностью прозрачные не учитываются
+    static ColorSummary computeArgb(const QRgb *pixels, int width, int height, qsizetype stride, bool hasAlpha);
+};
+
+#endif // COLORSUMMARY_H
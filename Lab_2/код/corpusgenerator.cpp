@@ -0,0 +1,397 @@
+#include "corpusgenerator.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QThreadPool>
+#include <QRandomGenerator>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+enum Variant {
+    PngRgb, PngArgb, PngGray, PngIndexed, JpegRgb, JpegGray,
+    BmpRgb, BmpIndexed, GifStill, GifAnimated, TiffImage, PcxImage, VariantCount
+};
+
+const char *suffixOf(Variant variant)
+{
+    switch (variant) {
+    case PngRgb: case PngArgb: case PngGray: case PngIndexed: return "png";
+    case JpegRgb: case JpegGray:                              return "jpg";
+    case BmpRgb: case BmpIndexed:                             return "bmp";
+    case GifStill: case GifAnimated:                          return "gif";
+    case TiffImage:                                           return "tif";
+    default:                                                  return "pcx";
+    }
+}
+
+void appendLe16(QByteArray &out, quint16 value)
+{
+    out.append(char(value & 0xFF));
+    out.append(char(value >> 8));
+}
+
+void appendLe32(QByteArray &out, quint32 value)
+{
+    appendLe16(out, quint16(value & 0xFFFF));
+    appendLe16(out, quint16(value >> 16));
+}
+
+// Узор из градиента, полос и шума: сжимается примерно как фотографии
+// и рисунки, а не как одноцветная заливка
+void fillPattern(uchar *pixels, int width, int height, int channels, QRandomGenerator &random)
+{
+    int ax = 1 + random.bounded(7);
+    int ay = 1 + random.bounded(7);
+    int stripes = 3 + random.bounded(5);
+    int noise = random.bounded(64);
+    quint32 state = random.generate() | 1;
+
+    for (int y = 0; y < height; ++y) {
+        uchar *line = pixels + qsizetype(y) * width * channels;
+        for (int x = 0; x < width; ++x) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            int base = x * ax + y * ay + (((x >> stripes) ^ (y >> stripes)) & 1) * 96;
+            for (int c = 0; c < channels; ++c) {
+                line[x * channels + c] = uchar(base + c * 85 + int((state >> (c * 8)) % quint32(noise + 1)));
+            }
+        }
+    }
+}
+
+QVector<QRgb> randomPalette(QRandomGenerator &random)
+{
+    QVector<QRgb> palette(256);
+    for (QRgb &color : palette) {
+        color = 0xFF000000u | (random.generate() & 0xFFFFFF);
+    }
+    return palette;
+}
+
+}
+
+CorpusGenerator::CorpusGenerator(const QString &directory, quint32 seed)
+    : directory(directory), seed(seed), nextIndex(0), fileCount(0), byteCount(0), failed(false)
+{
+}
+
+bool CorpusGenerator::generate(qint64 count, int threads)
+{
+    nextIndex = 0;
+    fileCount = 0;
+    byteCount = 0;
+    failed = false;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    for (int i = 0; i < threads; ++i) {
+        pool.start([this, count]() { work(count); });
+    }
+    pool.waitForDone();
+    return !failed;
+}
+
+qint64 CorpusGenerator::generatedFiles() const
+{
+    return fileCount;
+}
+
+qint64 CorpusGenerator::generatedBytes() const
+{
+    return byteCount;
+}
+
+void CorpusGenerator::work(qint64 count)
+{
+    forever {
+        qint64 index = nextIndex++;
+        if (index >= count || failed) {
+            return;
+        }
+        if (!writeFile(index)) {
+            failed = true;
+        }
+    }
+}
+
+bool CorpusGenerator::writeFile(qint64 index)
+{
+    QRandomGenerator random(seed ^ quint32(index * 2654435761u) ^ quint32(index >> 32));
+
+    Variant variant = Variant(random.bounded(int(VariantCount)));
+
+    // Размеры с длинным хвостом: в основном до 80 px, иногда до 512 и до 2048
+    int side;
+    int roll = random.bounded(64);
+    if (roll == 0) {
+        side = 512 + random.bounded(1537);
+    } else if (roll < 8) {
+        side = 80 + random.bounded(433);
+    } else {
+        side = 16 + random.bounded(65);
+    }
+    int width = side;
+    int height = qBound(1, side * (50 + random.bounded(151)) / 100, 2048);
+
+    static const int dpis[] = { 72, 96, 150, 300 };
+    int dpi = dpis[random.bounded(4)];
+
+    QString subdirectory = QString("%1/%2").arg(directory).arg(index / FilesPerDirectory, 4, 10, QChar('0'));
+    if (index % FilesPerDirectory == 0 || !QDir(subdirectory).exists()) {
+        QDir().mkpath(subdirectory);
+    }
+    QString fileName = QString("%1/img%2.%3").arg(subdirectory).arg(index, 7, 10, QChar('0')).arg(suffixOf(variant));
+
+    bool gray = variant == PngGray || variant == JpegGray || (variant == TiffImage && random.bounded(2));
+    bool indexed = variant == PngIndexed || variant == BmpIndexed || variant == GifStill || variant == GifAnimated
+                   || (variant == PcxImage && random.bounded(2));
+    int channels = (gray || indexed) ? 1 : (variant == PngArgb ? 4 : 3);
+
+    QByteArray pixels(qsizetype(width) * height * channels, Qt::Uninitialized);
+    fillPattern(reinterpret_cast<uchar *>(pixels.data()), width, height, channels, random);
+    const uchar *data = reinterpret_cast<const uchar *>(pixels.constData());
+
+    QByteArray encoded;
+    switch (variant) {
+    case GifStill:
+    case GifAnimated:
+        encoded = encodeGif(data, width, height, randomPalette(random), variant == GifAnimated ? 3 : 1);
+        break;
+    case TiffImage:
+        encoded = encodeTiff(data, width, height, channels, dpi);
+        break;
+    case PcxImage:
+        encoded = encodePcx(data, width, height, channels, randomPalette(random), dpi);
+        break;
+    default:
+        break;
+    }
+
+    if (!encoded.isEmpty()) {
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly) || file.write(encoded) != encoded.size()) {
+            return false;
+        }
+        byteCount += encoded.size();
+        ++fileCount;
+        return true;
+    }
+
+    // Остальное записывает сам Qt
+    QImage::Format format = indexed ? QImage::Format_Indexed8
+                          : gray ? QImage::Format_Grayscale8
+                          : channels == 4 ? QImage::Format_ARGB32 : QImage::Format_RGB32;
+    QImage image(width, height, format);
+    if (indexed) {
+        image.setColorTable(randomPalette(random));
+    }
+    for (int y = 0; y < height; ++y) {
+        const uchar *source = data + qsizetype(y) * width * channels;
+        if (channels == 1) {
+            std::memcpy(image.scanLine(y), source, width);
+            continue;
+        }
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            const uchar *p = source + x * channels;
+            line[x] = qRgba(p[0], p[1], p[2], channels == 4 ? p[3] : 255);
+        }
+    }
+    int dotsPerMeter = qRound(dpi * 39.3701);
+    image.setDotsPerMeterX(dotsPerMeter);
+    image.setDotsPerMeterY(dotsPerMeter);
+
+    int quality = (variant == JpegRgb || variant == JpegGray) ? 40 + random.bounded(56) : -1;
+    if (!image.save(fileName, nullptr, quality)) {
+        return false;
+    }
+    byteCount += QFileInfo(fileName).size();
+    ++fileCount;
+    return true;
+}
+
+QByteArray CorpusGenerator::encodeGif(const uchar *indices, int width, int height, const QVector<QRgb> &palette, int frames)
+{
+    QByteArray out("GIF89a");
+    appendLe16(out, quint16(width));
+    appendLe16(out, quint16(height));
+    out.append(char(0xF7));                // глобальная палитра из 256 цветов
+    out.append(char(0));
+    out.append(char(0));
+    for (int i = 0; i < 256; ++i) {
+        QRgb color = palette.value(i);
+        out.append(char(qRed(color)));
+        out.append(char(qGreen(color)));
+        out.append(char(qBlue(color)));
+    }
+
+    // LZW без словаря: каждый индекс пишется 9-битным кодом, а код очистки
+    // повторяется раньше, чем декодер перешёл бы на 10 бит. Файл больше
+    // обычного, но это корректный GIF, который читает любой декодер.
+    const int clearCode = 256;
+    const int endCode = 257;
+    const int clearInterval = 250;
+
+    for (int frame = 0; frame < frames; ++frame) {
+        out.append("\x21\xF9\x04", 3);     // Graphic Control Extension
+        out.append(char(0x04));             // кадр остаётся на месте
+        appendLe16(out, 10);                // 0.1 с
+        out.append(char(0));
+        out.append(char(0));
+
+        out.append(char(0x2C));
+        appendLe16(out, 0);
+        appendLe16(out, 0);
+        appendLe16(out, quint16(width));
+        appendLe16(out, quint16(height));
+        out.append(char(0));
+        out.append(char(8));                // минимальный размер кода LZW
+
+        QByteArray block;
+        quint32 bits = 0;
+        int bitCount = 0;
+        auto emitCode = [&](int code) {
+            bits |= quint32(code) << bitCount;
+            bitCount += 9;
+            while (bitCount >= 8) {
+                block.append(char(bits & 0xFF));
+                bits >>= 8;
+                bitCount -= 8;
+            }
+        };
+
+        qint64 pixelCount = qint64(width) * height;
+        for (qint64 i = 0; i < pixelCount; ++i) {
+            if (i % clearInterval == 0) {
+                emitCode(clearCode);
+            }
+            emitCode(indices[i]);
+        }
+        emitCode(endCode);
+        if (bitCount > 0) {
+            block.append(char(bits & 0xFF));
+        }
+
+        for (qsizetype offset = 0; offset < block.size(); offset += 255) {
+            qsizetype length = qMin<qsizetype>(255, block.size() - offset);
+            out.append(char(length));
+            out.append(block.constData() + offset, length);
+        }
+        out.append(char(0));
+    }
+
+    out.append(char(0x3B));
+    return out;
+}
+
+QByteArray CorpusGenerator::encodeTiff(const uchar *pixels, int width, int height, int channels, int dpi)
+{
+    // Несжатый baseline TIFF с порядком байтов Intel и одной полосой
+    const int entryCount = 13;
+    const quint32 ifdOffset = 8;
+    const quint32 extraOffset = ifdOffset + 2 + entryCount * 12 + 4;
+    const quint32 bitsOffset = extraOffset;
+    const quint32 resolutionOffset = bitsOffset + 8;
+    const quint32 dataOffset = resolutionOffset + 8;
+    const quint32 dataSize = quint32(width) * height * channels;
+
+    QByteArray out("II*\0", 4);
+    appendLe32(out, ifdOffset);
+    appendLe16(out, entryCount);
+
+    auto entry = [&out](quint16 tag, quint16 type, quint32 count, quint32 value) {
+        appendLe16(out, tag);
+        appendLe16(out, type);
+        appendLe32(out, count);
+        if (type == 3 && count == 1) {
+            appendLe16(out, quint16(value));
+            appendLe16(out, 0);
+        } else {
+            appendLe32(out, value);
+        }
+    };
+
+    entry(256, 4, 1, quint32(width));
+    entry(257, 4, 1, quint32(height));
+    entry(258, 3, quint32(channels), channels == 1 ? 8 : bitsOffset);
+    entry(259, 3, 1, 1);
+    entry(262, 3, 1, channels == 1 ? 1 : 2);
+    entry(273, 4, 1, dataOffset);
+    entry(277, 3, 1, quint32(channels));
+    entry(278, 4, 1, quint32(height));
+    entry(279, 4, 1, dataSize);
+    entry(282, 5, 1, resolutionOffset);
+    entry(283, 5, 1, resolutionOffset);
+    entry(284, 3, 1, 1);
+    entry(296, 3, 1, 2);
+    appendLe32(out, 0);
+
+    for (int i = 0; i < 4; ++i) {
+        appendLe16(out, 8);
+    }
+    appendLe32(out, quint32(dpi));
+    appendLe32(out, 1);
+
+    out.append(reinterpret_cast<const char *>(pixels), dataSize);
+    return out;
+}
+
+QByteArray CorpusGenerator::encodePcx(const uchar *pixels, int width, int height, int channels,
+                                      const QVector<QRgb> &palette, int dpi)
+{
+    int bytesPerLine = (width + 1) & ~1;
+
+    QByteArray out(128, '\0');
+    uchar *header = reinterpret_cast<uchar *>(out.data());
+    header[0] = 0x0A;
+    header[1] = 5;
+    header[2] = 1;                          // RLE
+    header[3] = 8;
+    qToLittleEndian(quint16(width - 1), header + 8);
+    qToLittleEndian(quint16(height - 1), header + 10);
+    qToLittleEndian(quint16(dpi), header + 12);
+    qToLittleEndian(quint16(dpi), header + 14);
+    header[65] = uchar(channels);
+    qToLittleEndian(quint16(bytesPerLine), header + 66);
+    qToLittleEndian(quint16(channels == 1 ? 2 : 1), header + 68);
+
+    // Каждая строка каждой плоскости кодируется отдельно: серии до 63 байт,
+    // одиночный байт >= 0xC0 тоже пишется как серия
+    QByteArray plane(bytesPerLine, '\0');
+    for (int y = 0; y < height; ++y) {
+        const uchar *line = pixels + qsizetype(y) * width * channels;
+        for (int c = 0; c < channels; ++c) {
+            for (int x = 0; x < width; ++x) {
+                plane[x] = char(line[x * channels + c]);
+            }
+            const uchar *data = reinterpret_cast<const uchar *>(plane.constData());
+            int x = 0;
+            while (x < bytesPerLine) {
+                int run = 1;
+                while (x + run < bytesPerLine && run < 63 && data[x + run] == data[x]) {
+                    ++run;
+                }
+                if (run > 1 || data[x] >= 0xC0) {
+                    out.append(char(0xC0 | run));
+                }
+                out.append(char(data[x]));
+                x += run;
+            }
+        }
+    }
+
+    if (channels == 1) {
+        out.append(char(0x0C));
+        for (int i = 0; i < 256; ++i) {
+            QRgb color = palette.value(i);
+            out.append(char(qRed(color)));
+            out.append(char(qGreen(color)));
+            out.append(char(qBlue(color)));
+        }
+    }
+    return out;
+}
@@ -0,0 +1,48 @@
+#ifndef CORPUSGENERATOR_H
+#define CORPUSGENERATOR_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QRgb>
+#include <atomic>
+
+// Синтетический набор изображений для замеров на больших объёмах.
+// Файл с номером i всегда получается одинаковым при том же seed:
+// формат, размер, глубина и разрешение выбираются по номеру. Большая
+// часть файлов мелкие, изредка попадаются изображения до 2048 px.
+// Файлы раскладываются по подпапкам по 1000 штук.
+class CorpusGenerator
+{
+public:
+    static const int FilesPerDirectory = 1000;
+
+    explicit CorpusGenerator(const QString &directory, quint32 seed = 1);
+
+    // Создаёт файлы с номерами от 0 до count - 1 в нескольких потоках
+    bool generate(qint64 count, int threads);
+
+    qint64 generatedFiles() const;
+    qint64 generatedBytes() const;
+
+    // Кодировщики форматов, которые Qt не записывает.
+    // Пиксели идут строками подряд, по байту на канал или индекс палитры.
+    static QByteArray encodeGif(const uchar *indices, int width, int height, const QVector<QRgb> &palette, int frames);
+    static QByteArray encodeTiff(const uchar *pixels, int width, int height, int channels, int dpi);
+    static QByteArray encodePcx(const uchar *pixels, int width, int height, int channels,
+                                const QVector<QRgb> &palette, int dpi);
+
+private:
+    QString directory;
+    quint32 seed;
+
+    std::atomic<qint64> nextIndex;
+    std::atomic<qint64> fileCount;
+    std::atomic<qint64> byteCount;
+    std::atomic<bool> failed;
+
+    void work(qint64 count);
+    bool writeFile(qint64 index);
+};
+
+#endif // CORPUSGENERATOR_H
@@ -0,0 +1,111 @@
+#include "directoryscanner.h"
+#include <QDirIterator>
+#include <QMutexLocker>
+
+DirectoryScanner::DirectoryScanner(QObject *parent)
+    : QObject(parent), foundCount(0), cancelled(false), scanning(false), running(false)
+{
+    pool.setMaxThreadCount(1);
+    flushTimer.setInterval(50);
+    connect(&flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+DirectoryScanner::~DirectoryScanner()
+{
+    cancelled = true;
+    pool.waitForDone();
+}
+
+void DirectoryScanner::start(const QString &folder)
+{
+    cancel();
+    pool.waitForDone();
+
+    pending.clear();
+    foundCount = 0;
+    cancelled = false;
+    scanning = true;
+    running = true;
+
+    pool.start([this, folder]() { scan(folder); });
+    flushTimer.start();
+}
+
+void DirectoryScanner::cancel()
+{
+    cancelled = true;
+}
+
+bool DirectoryScanner::isRunning() const
+{
+    return running;
+}
+
+bool DirectoryScanner::isImageFile(QStringView path)
+{
+    static const QLatin1String suffixes[] = {
+        QLatin1String("jpg"), QLatin1String("jpeg"), QLatin1String("gif"), QLatin1String("tif"),
+        QLatin1String("tiff"), QLatin1String("bmp"), QLatin1String("png"), QLatin1String("pcx")
+    };
+
+    qsizetype dot = path.lastIndexOf(QLatin1Char('.'));
+    if (dot < 0 || path.size() - dot > 5) {
+        return false;
+    }
+    QStringView suffix = path.mid(dot + 1);
+    for (QLatin1String known : suffixes) {
+        if (suffix.compare(known, Qt::CaseInsensitive) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DirectoryScanner::scan(const QString &folder)
+{
+    // Без фильтров имён: QDirIterator проверял бы каждый файл регулярным
+    // выражением, а суффикс проще сравнить прямо в строке пути
+    QDirIterator it(folder, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+
+    QStringList batch;
+    while (!cancelled && it.hasNext()) {
+        QString path = it.next();
+        if (!isImageFile(path)) {
+            continue;
+        }
+        batch.append(path);
+
+        // Мьютекс берётся раз на пачку, а не на каждый файл
+        if (batch.count() >= 256) {
+            QMutexLocker locker(&mutex);
+            pending.append(batch);
+            batch.clear();
+        }
+    }
+
+    QMutexLocker locker(&mutex);
+    pending.append(batch);
+    scanning = false;
+}
+
+void DirectoryScanner::flush()
+{
+    QStringList batch;
+    bool done;
+    {
+        QMutexLocker locker(&mutex);
+        batch.swap(pending);
+        done = !scanning;
+    }
+
+    if (!batch.isEmpty() && !cancelled) {
+        foundCount += batch.count();
+        emit filesFound(batch);
+    }
+
+    if (done) {
+        flushTimer.stop();
+        running = false;
+        emit finished(foundCount);
+    }
+}
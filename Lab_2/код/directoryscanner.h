@@ -0,0 +1,50 @@
+#ifndef DIRECTORYSCANNER_H
+#define DIRECTORYSCANNER_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QMutex>
+#include <QTimer>
+#include <QStringList>
+#include <atomic>
+
+// Рекурсивный обход папки в отдельном потоке. Найденные пути отдаются
+// пачками по таймеру, так что анализ можно начинать до конца обхода.
+class DirectoryScanner : public QObject
+{
+    Q_OBJECT
+
+private:
+    QThreadPool pool;
+    QTimer flushTimer;
+
+    QMutex mutex;
+    QStringList pending;
+    int foundCount;
+
+    std::atomic<bool> cancelled;
+    std::atomic<bool> scanning;
+    bool running;
+
+    void scan(const QString &folder);
+
+public:
+    explicit DirectoryScanner(QObject *parent = nullptr);
+    ~DirectoryScanner();
+
+    void start(const QString &folder);
+    void cancel();
+    bool isRunning() const;
+
+    // Проверка только по строке пути, без QFileInfo
+    static bool isImageFile(QStringView path);
+
+signals:
+    void filesFound(const QStringList &batch);
+    void finished(int total);
+
+private slots:
+    void flush();
+};
+
+#endif // DIRECTORYSCANNER_H
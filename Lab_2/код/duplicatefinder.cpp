@@ -0,0 +1,197 @@
+#include "duplicatefinder.h"
+#include "perceptualhash.h"
+#include <QMutexLocker>
+#include <QHash>
+#include <algorithm>
+
+HammingIndex::HammingIndex(const QVector<quint64> &hashValues)
+    : hashes(hashValues)
+{
+    // Сортировка подсчётом по значению каждой части
+    for (int part = 0; part < Parts; ++part) {
+        QVector<int> &offset = offsets[part];
+        offset = QVector<int>(Buckets + 1, 0);
+        for (quint64 hash : hashes) {
+            ++offset[((hash >> (part * PartBits)) & 0xFFFF) + 1];
+        }
+        for (int key = 0; key < Buckets; ++key) {
+            offset[key + 1] += offset[key];
+        }
+
+        QVector<int> next = offset;
+        QVector<int> &position = positions[part];
+        position = QVector<int>(hashes.count());
+        for (int i = 0; i < hashes.count(); ++i) {
+            position[next[(hashes[i] >> (part * PartBits)) & 0xFFFF]++] = i;
+        }
+    }
+}
+
+int HammingIndex::count() const
+{
+    return int(hashes.count());
+}
+
+void HammingIndex::find(quint64 hash, int radius, QVector<int> &result) const
+{
+    if (hashes.isEmpty() || radius < 0) {
+        return;
+    }
+
+    // Кандидаты проверяются сразу, без промежуточного списка: их тысячи,
+    // а подходящих единицы
+    QVector<int> found;
+    const int *offset = nullptr;
+    const int *position = nullptr;
+    auto check = [&](int key) {
+        for (int i = offset[key]; i < offset[key + 1]; ++i) {
+            if (PerceptualHash::distance(hash, hashes[position[i]]) <= radius) {
+                found.append(position[i]);
+            }
+        }
+    };
+
+    // Все значения части на расстоянии до partRadius: перебор сочетаний
+    // переставляемых битов, при partRadius <= 2 это не больше 137 корзин
+    radius = qMin(radius, 15);
+    int partRadius = radius / Parts;
+    for (int part = 0; part < Parts; ++part) {
+        offset = offsets[part].constData();
+        position = positions[part].constData();
+        int key = int((hash >> (part * PartBits)) & 0xFFFF);
+        check(key);
+        for (int a = 0; a < PartBits && partRadius >= 1; ++a) {
+            check(key ^ (1 << a));
+            for (int b = a + 1; b < PartBits && partRadius >= 2; ++b) {
+                check(key ^ (1 << a) ^ (1 << b));
+                for (int c = b + 1; c < PartBits && partRadius >= 3; ++c) {
+                    check(key ^ (1 << a) ^ (1 << b) ^ (1 << c));
+                }
+            }
+        }
+    }
+
+    // Хэш, близкий сразу по нескольким частям, найден несколько раз
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    result.append(found);
+}
+
+DuplicateFinder::DuplicateFinder(QObject *parent)
+    : QObject(parent), pendingGeneration(0), generation(0), cancelled(false), running(false)
+{
+    pool.setMaxThreadCount(1);
+}
+
+DuplicateFinder::~DuplicateFinder()
+{
+    cancelled = true;
+    pool.waitForDone();
+}
+
+QList<QList<int>> DuplicateFinder::group(const QVector<int> &ids, const QVector<quint64> &pHashes,
+                                             const QVector<quint64> &dHashes, int radius,
+                                             const std::atomic<bool> *cancel)
+{
+    // Объединение множеств с сокращением путей, индексы - позиции в ids
+    QVector<int> parent(ids.count());
+    for (int i = 0; i < parent.count(); ++i) {
+        parent[i] = i;
+    }
+    auto root = [&parent](int i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+
+    // Пара находится с обеих сторон; объединяется только при j < i
+    HammingIndex index(pHashes);
+    QVector<int> candidates;
+    for (int i = 0; i < ids.count(); ++i) {
+        if (cancel && *cancel) {
+            return QList<QList<int>>();
+        }
+        candidates.clear();
+        index.find(pHashes[i], radius, candidates);
+        for (int j : candidates) {
+            if (j < i && PerceptualHash::distance(dHashes[i], dHashes[j]) <= radius) {
+                parent[root(i)] = root(j);
+            }
+        }
+    }
+
+    QHash<int, int> groupOf;   // корень -> номер группы
+    QList<QList<int>> groups;
+    for (int i = 0; i < ids.count(); ++i) {
+        int r = root(i);
+        auto it = groupOf.constFind(r);
+        if (it == groupOf.constEnd()) {
+            it = groupOf.insert(r, int(groups.count()));
+            groups.append(QList<int>());
+        }
+        groups[it.value()].append(ids[i]);
+    }
+
+    groups.erase(std::remove_if(groups.begin(), groups.end(), [](const QList<int> &g) { return g.count() < 2; }),
+                 groups.end());
+    std::stable_sort(groups.begin(), groups.end(), [](const QList<int> &a, const QList<int> &b) {
+        return a.count() > b.count();
+    });
+    return groups;
+}
+
+void DuplicateFinder::start(const QVector<int> &ids, const QVector<quint64> &pHashes,
+                            const QVector<quint64> &dHashes, int radius)
+{
+    cancel();
+    cancelled = false;
+    running = true;
+    int searchGeneration = ++generation;
+    pool.start([this, searchGeneration, ids, pHashes, dHashes, radius]() {
+        search(searchGeneration, ids, pHashes, dHashes, radius);
+    });
+}
+
+void DuplicateFinder::cancel()
+{
+    cancelled = true;
+    pool.clear();
+    pool.waitForDone();
+    running = false;
+}
+
+bool DuplicateFinder::isRunning() const
+{
+    return running;
+}
+
+void DuplicateFinder::search(int searchGeneration, const QVector<int> &ids, const QVector<quint64> &pHashes,
+                             const QVector<quint64> &dHashes, int radius)
+{
+    QList<QList<int>> groups = group(ids, pHashes, dHashes, radius, &cancelled);
+    if (cancelled) {
+        return;
+    }
+    {
+        QMutexLocker locker(&mutex);
+        pendingGroups = groups;
+        pendingGeneration = searchGeneration;
+    }
+    QMetaObject::invokeMethod(this, "deliver", Qt::QueuedConnection);
+}
+
+void DuplicateFinder::deliver()
+{
+    QList<QList<int>> groups;
+    {
+        QMutexLocker locker(&mutex);
+        if (pendingGeneration != generation || !running) {
+            return;
+        }
+        groups.swap(pendingGroups);
+    }
+    running = false;
+    emit groupsFound(groups);
+}
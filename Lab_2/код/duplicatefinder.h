@@ -0,0 +1,83 @@
+#ifndef DUPLICATEFINDER_H
+#define DUPLICATEFINDER_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QMutex>
+#include <QVector>
+#include <QList>
+#include <atomic>
+
+// Поиск 64-битных хэшей в радиусе по Хэммингу (multi-index hashing).
+// Хэш делится на 4 части по 16 бит, и каждая часть - ключ своей таблицы.
+// Если хэши отличаются не больше чем на r бит, то хотя бы в одной части
+// они отличаются не больше чем на r / 4 бит (принцип Дирихле), поэтому
+// кандидаты - содержимое корзин, отличающихся от части запроса на
+// 0..r/4 бит, а не все хэши. BK-дерево здесь не подходит: расстояния
+// между 64-битными хэшами скучены около 32, и поиск обходит почти всё дерево.
+// Таблицы строятся один раз по всем хэшам и лежат сплошными массивами
+// (смещения корзин и позиции), чтобы корзина читалась за один промах кэша.
+class HammingIndex
+{
+private:
+    enum { Parts = 4, PartBits = 16, Buckets = 1 << PartBits };
+
+    QVector<quint64> hashes;
+    QVector<int> offsets[Parts];     // начало корзины в positions, Buckets + 1 значение
+    QVector<int> positions[Parts];   // индексы в hashes, по корзинам
+
+public:
+    explicit HammingIndex(const QVector<quint64> &hashes);
+
+    int count() const;
+
+    // Дописывает в result индексы всех хэшей не дальше radius (не больше 15)
+    void find(quint64 hash, int radius, QVector<int> &result) const;
+};
+
+// Группировка похожих изображений в фоновом потоке. Пара считается
+// похожей, если и pHash, и dHash отличаются не больше чем на radius бит:
+// кандидаты ищутся по pHash в HammingIndex, dHash отсекает случайные
+// совпадения. Группы - связные компоненты (объединение множеств).
+class DuplicateFinder : public QObject
+{
+    Q_OBJECT
+
+private:
+    QThreadPool pool;
+    QMutex mutex;
+    QList<QList<int>> pendingGroups;
+    int pendingGeneration;
+    int generation;            // номер последнего поиска: результаты отменённых не выдаются
+    std::atomic<bool> cancelled;
+    bool running;
+
+    void search(int searchGeneration, const QVector<int> &ids, const QVector<quint64> &pHashes,
+                const QVector<quint64> &dHashes, int radius);
+
+public:
+    // До 7 бит из 64: части сравниваются с точностью до одного бита (17 корзин на часть)
+    static const int DefaultRadius = 7;
+
+    explicit DuplicateFinder(QObject *parent = nullptr);
+    ~DuplicateFinder();
+
+    // Группы из двух и более id, крупные первыми. Синхронно, можно из любого потока
+    static QList<QList<int>> group(const QVector<int> &ids, const QVector<quint64> &pHashes,
+                                       const QVector<quint64> &dHashes, int radius = DefaultRadius,
+                                       const std::atomic<bool> *cancel = nullptr);
+
+    // Предыдущий поиск отменяется
+    void start(const QVector<int> &ids, const QVector<quint64> &pHashes, const QVector<quint64> &dHashes,
+               int radius = DefaultRadius);
+    void cancel();
+    bool isRunning() const;
+
+private slots:
+    void deliver();
+
+signals:
+    void groupsFound(const QList<QList<int>> &groups);
+};
+
+#endif // DUPLICATEFINDER_H
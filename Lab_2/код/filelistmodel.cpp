@@ -0,0 +1,62 @@
+#include "filelistmodel.h"
+
+FileListModel::FileListModel(QObject *parent)
+    : QAbstractListModel(parent), shownCount(0)
+{
+}
+
+int FileListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : shownCount;
+}
+
+QVariant FileListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    if (role == Qt::DisplayRole) {
+        return store.fileName(index.row()).toString();
+    }
+    if (role == Qt::ToolTipRole) {
+        return store.path(index.row());
+    }
+    return QVariant();
+}
+
+QStringList FileListModel::addFiles(const QStringList &files)
+{
+    QStringList added;
+    for (const QString &filePath : files) {
+        if (store.add(filePath)) {
+            added.append(filePath);
+        }
+    }
+
+    // Хранилище уже дополнено, но представление узнаёт о строках одной вставкой
+    if (store.count() > shownCount) {
+        beginInsertRows(QModelIndex(), shownCount, store.count() - 1);
+        shownCount = store.count();
+        endInsertRows();
+    }
+    return added;
+}
+
+void FileListModel::clear()
+{
+    beginResetModel();
+    store.clear();
+    shownCount = 0;
+    endResetModel();
+}
+
+int FileListModel::count() const
+{
+    return store.count();
+}
+
+QString FileListModel::path(int i) const
+{
+    return store.path(i);
+}
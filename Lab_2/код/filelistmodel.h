@@ -0,0 +1,31 @@
+#ifndef FILELISTMODEL_H
+#define FILELISTMODEL_H
+
+#include <QAbstractListModel>
+#include "pathstore.h"
+
+// Список выбранных файлов для QListView поверх PathStore:
+// строка хранится один раз, имя для отображения берётся по запросу
+class FileListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+private:
+    PathStore store;
+    int shownCount;
+
+public:
+    explicit FileListModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    // Возвращает только пути, которых ещё не было в списке
+    QStringList addFiles(const QStringList &files);
+    void clear();
+
+    int count() const;
+    QString path(int i) const;
+};
+
+#endif // FILELISTMODEL_H
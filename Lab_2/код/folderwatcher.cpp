@@ -0,0 +1,288 @@
+#include "folderwatcher.h"
+#include "directoryscanner.h"
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QMutexLocker>
+
+FolderWatcher::FolderWatcher(QObject *parent)
+    : QObject(parent), pendingSettle(false), cancelled(false), watching(false)
+{
+    watcher = new QFileSystemWatcher(this);
+    pool.setMaxThreadCount(1);
+
+    debounceTimer.setSingleShot(true);
+    debounceTimer.setInterval(DebounceInterval);
+    settleTimer.setSingleShot(true);
+    settleTimer.setInterval(SettleInterval);
+
+    connect(watcher, SIGNAL(directoryChanged(QString)), this, SLOT(onDirectoryChanged(QString)));
+    connect(&debounceTimer, SIGNAL(timeout()), this, SLOT(processChanges()));
+    connect(&settleTimer, SIGNAL(timeout()), this, SLOT(checkSettling()));
+}
+
+FolderWatcher::~FolderWatcher()
+{
+    cancelled = true;
+    pool.waitForDone();
+}
+
+void FolderWatcher::start(const QString &folder, qint64 since)
+{
+    stop();
+
+    cancelled = false;
+    watching = true;
+    pool.start([this, folder, since]() { takeSnapshot(folder, since); });
+}
+
+void FolderWatcher::stop()
+{
+    cancelled = true;
+    pool.clear();
+    pool.waitForDone();
+
+    watching = false;
+    debounceTimer.stop();
+    settleTimer.stop();
+    dirtyDirectories.clear();
+    snapshot.clear();
+    settling.clear();
+
+    QStringList directories = watcher->directories();
+    if (!directories.isEmpty()) {
+        watcher->removePaths(directories);
+    }
+
+    QMutexLocker locker(&mutex);
+    pendingDirectories.clear();
+    pendingFiles.clear();
+    pendingSettle = false;
+}
+
+bool FolderWatcher::isWatching() const
+{
+    return watching;
+}
+
+FolderWatcher::DirectoryState FolderWatcher::readDirectory(const QString &directory, QStringList &subdirectories)
+{
+    DirectoryState state;
+    QDirIterator it(directory, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        it.next();
+        QFileInfo fileInfo = it.fileInfo();
+        if (fileInfo.isDir()) {
+            subdirectories.append(fileInfo.filePath());
+        } else if (DirectoryScanner::isImageFile(fileInfo.fileName())) {
+            state.insert(fileInfo.fileName(), FileState{ fileInfo.size(), changeTime(fileInfo) });
+        }
+    }
+    return state;
+}
+
+qint64 FolderWatcher::changeTime(const QFileInfo &fileInfo)
+{
+    // Копия сохраняет время изменения оригинала, поэтому учитывается и время
+    // создания (Windows), и время смены метаданных (Linux, меняется при переименовании)
+    qint64 time = fileInfo.lastModified().toMSecsSinceEpoch();
+    QDateTime born = fileInfo.birthTime();
+    if (born.isValid()) {
+        time = qMax(time, born.toMSecsSinceEpoch());
+    }
+    QDateTime changed = fileInfo.metadataChangeTime();
+    if (changed.isValid()) {
+        time = qMax(time, changed.toMSecsSinceEpoch());
+    }
+    return time;
+}
+
+void FolderWatcher::addDirectory(const QString &directory, QStringList &directories, QStringList *files)
+{
+    // Папка обходится в ширину; files == nullptr при первом снимке,
+    // когда все файлы уже есть в списке после обычного обхода
+    QStringList queue(directory);
+    while (!queue.isEmpty() && !cancelled) {
+        QString current = queue.takeFirst();
+        DirectoryState state = readDirectory(current, queue);
+        if (files) {
+            for (auto it = state.constBegin(); it != state.constEnd(); ++it) {
+                files->append(current + '/' + it.key());
+            }
+        }
+        snapshot.insert(current, state);
+        directories.append(current);
+    }
+}
+
+void FolderWatcher::takeSnapshot(const QString &folder, qint64 since)
+{
+    QStringList directories;
+    addDirectory(folder, directories, nullptr);
+
+    // Снимок снимается после обхода: то, что изменилось между ними,
+    // обход мог пропустить или застать старую версию файла
+    QStringList changed;
+    for (const QString &directory : directories) {
+        const DirectoryState state = snapshot.value(directory);
+        for (auto it = state.constBegin(); it != state.constEnd(); ++it) {
+            if (it->modified >= since) {
+                changed.append(directory + '/' + it.key());
+            }
+        }
+    }
+    addSettling(changed);
+    post(directories, QStringList());
+}
+
+void FolderWatcher::rescan(const QStringList &directories)
+{
+    QStringList newDirectories;
+    QStringList changed;
+
+    for (const QString &directory : directories) {
+        if (cancelled) {
+            return;
+        }
+        if (!QFileInfo(directory).isDir()) {
+            // Удалённую папку QFileSystemWatcher перестаёт отслеживать сам
+            snapshot.remove(directory);
+            continue;
+        }
+
+        QStringList subdirectories;
+        DirectoryState current = readDirectory(directory, subdirectories);
+        const DirectoryState previous = snapshot.value(directory);
+        for (auto it = current.constBegin(); it != current.constEnd(); ++it) {
+            auto old = previous.constFind(it.key());
+            if (old == previous.constEnd() || old->size != it->size || old->modified != it->modified) {
+                changed.append(directory + '/' + it.key());
+            }
+        }
+        snapshot.insert(directory, current);
+
+        // Скопированная целиком папка приходит одним событием на родителя
+        for (const QString &subdirectory : subdirectories) {
+            if (!snapshot.contains(subdirectory)) {
+                addDirectory(subdirectory, newDirectories, &changed);
+            }
+        }
+    }
+
+    addSettling(changed);
+    post(newDirectories, QStringList());
+}
+
+void FolderWatcher::addSettling(const QStringList &files)
+{
+    // Состояние берётся из только что обновлённого снимка
+    for (const QString &filePath : files) {
+        qsizetype slash = filePath.lastIndexOf('/');
+        const DirectoryState state = snapshot.value(filePath.left(slash));
+        auto it = state.constFind(filePath.mid(slash + 1));
+        if (it != state.constEnd()) {
+            settling.insert(filePath, it.value());
+        }
+    }
+}
+
+void FolderWatcher::settle()
+{
+    // Файл отдаётся, когда две проверки подряд дали одно и то же состояние
+    QStringList stable;
+    for (auto it = settling.begin(); it != settling.end() && !cancelled;) {
+        QFileInfo fileInfo(it.key());
+        if (!fileInfo.exists()) {
+            it = settling.erase(it);
+            continue;
+        }
+        FileState current{ fileInfo.size(), changeTime(fileInfo) };
+        if (current.size != it->size || current.modified != it->modified) {
+            it.value() = current;
+            ++it;
+            continue;
+        }
+
+        // Снимок получает окончательное состояние, чтобы следующий обход
+        // папки не отдал тот же файл ещё раз
+        qsizetype slash = it.key().lastIndexOf('/');
+        auto directory = snapshot.find(it.key().left(slash));
+        if (directory != snapshot.end()) {
+            directory->insert(it.key().mid(slash + 1), current);
+        }
+        stable.append(it.key());
+        it = settling.erase(it);
+    }
+    post(QStringList(), stable);
+}
+
+void FolderWatcher::post(const QStringList &directories, const QStringList &files)
+{
+    if (cancelled || (directories.isEmpty() && files.isEmpty() && settling.isEmpty())) {
+        return;
+    }
+    {
+        QMutexLocker locker(&mutex);
+        pendingDirectories.append(directories);
+        pendingFiles.append(files);
+        pendingSettle = !settling.isEmpty();
+    }
+    QMetaObject::invokeMethod(this, "deliver", Qt::QueuedConnection);
+}
+
+void FolderWatcher::deliver()
+{
+    QStringList directories;
+    QStringList files;
+    bool recheck;
+    {
+        QMutexLocker locker(&mutex);
+        directories.swap(pendingDirectories);
+        files.swap(pendingFiles);
+        recheck = pendingSettle;
+    }
+    if (!watching) {
+        return;
+    }
+
+    if (recheck && !settleTimer.isActive()) {
+        settleTimer.start();
+    }
+    if (!directories.isEmpty()) {
+        watcher->addPaths(directories);
+    }
+    if (!files.isEmpty()) {
+        emit filesChanged(files);
+    }
+}
+
+void FolderWatcher::onDirectoryChanged(const QString &directory)
+{
+    // Каждое событие откладывает обработку, чтобы пачка событий
+    // от одного копирования перечитала папку один раз, но не дальше
+    // MaxDelay от первого события: в папку, куда файлы идут потоком,
+    // паузы в DebounceInterval может не быть вовсе
+    if (dirtyDirectories.isEmpty()) {
+        dirtySince.start();
+    }
+    dirtyDirectories.insert(directory);
+    debounceTimer.start(int(qBound(qint64(0), MaxDelay - dirtySince.elapsed(), qint64(DebounceInterval))));
+}
+
+void FolderWatcher::processChanges()
+{
+    if (!watching || dirtyDirectories.isEmpty()) {
+        return;
+    }
+
+    QStringList directories = dirtyDirectories.values();
+    dirtyDirectories.clear();
+    pool.start([this, directories]() { rescan(directories); });
+}
+
+void FolderWatcher::checkSettling()
+{
+    if (watching) {
+        pool.start([this]() { settle(); });
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef FOLDERWATCHER_H
+#define FOLDERWATCHER_H
+
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QThreadPool>
+#include <QMutex>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QFileInfo>
+#include <atomic>
+
+// Слежение за папкой с подпапками. События QFileSystemWatcher приходят
+// на папку, а не на файл, поэтому изменившиеся папки копятся, пока
+// события не утихнут, и затем перечитываются в фоне и сравниваются
+// со снимком (размер и время изменения каждого файла). Наружу отдаются
+// только новые и изменённые файлы.
+//
+// Событие на папку приходит при создании, удалении и переименовании
+// файлов, но не при записи в них. Поэтому новый или изменённый файл
+// сначала попадает в settling и перепроверяется по таймеру, пока две
+// проверки подряд не дадут одинаковые размер и время: файл, который ещё
+// копируется, отдаётся один раз, когда запись закончится. Перезапись
+// существующего файла на месте папку не меняет и замечается, только
+// если в той же папке было и другое событие.
+class FolderWatcher : public QObject
+{
+    Q_OBJECT
+
+private:
+    struct FileState
+    {
+        qint64 size;
+        qint64 modified;   // см. changeTime()
+    };
+    typedef QHash<QString, FileState> DirectoryState;   // имя файла -> состояние
+
+    QFileSystemWatcher *watcher;
+    QTimer debounceTimer;
+    QTimer settleTimer;
+    QSet<QString> dirtyDirectories;
+    QElapsedTimer dirtySince;             // с первого события в dirtyDirectories
+
+    // Снимок и settling читаются и меняются только в потоке пула (он один)
+    QThreadPool pool;
+    QHash<QString, DirectoryState> snapshot;
+    QHash<QString, FileState> settling;   // путь -> состояние при последней проверке
+
+    QMutex mutex;
+    QStringList pendingDirectories;
+    QStringList pendingFiles;
+    bool pendingSettle;
+
+    std::atomic<bool> cancelled;
+    bool watching;
+
+    void takeSnapshot(const QString &folder, qint64 since);
+    void rescan(const QStringList &directories);
+    void addDirectory(const QString &directory, QStringList &directories, QStringList *files);
+    void addSettling(const QStringList &files);
+    void settle();
+    void post(const QStringList &directories, const QStringList &files);
+
+    static DirectoryState readDirectory(const QString &directory, QStringList &subdirectories);
+    static qint64 changeTime(const QFileInfo &fileInfo);
+
+public:
+    // Пауза без событий, после которой изменения обрабатываются
+    static const int DebounceInterval = 500;
+    // Дольше этого события не откладывают обработку, даже если идут без пауз
+    static const int MaxDelay = 2000;
+    // Интервал перепроверки файлов, в которые, возможно, ещё идёт запись
+    static const int SettleInterval = 1000;
+
+    explicit FolderWatcher(QObject *parent = nullptr);
+    ~FolderWatcher();
+
+    // Файлы, изменённые с момента since (мс с начала эпохи), то есть
+    // после начала обхода, приходят в filesChanged сразу после снимка
+    void start(const QString &folder, qint64 since);
+    void stop();
+    bool isWatching() const;
+
+signals:
+    void filesChanged(const QStringList &files);
+
+private slots:
+    void onDirectoryChanged(const QString &directory);
+    void processChanges();
+    void checkSettling();
+    void deliver();
+};
+
+#endif // FOLDERWATCHER_H
@@ -0,0 +1,332 @@
+#include "imageanalysis.h"
+#include "analysisprofiler.h"
+#include "pixelstats.h"
+#include "pixelsampler.h"
+#include "colorsummary.h"
+#include "perceptualhash.h"
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImage>
+#include <QPixelFormat>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QMutexLocker>
+#include <QDebug>
+
+namespace {
+
+// Расширения-синонимы приводятся к имени формата
+QString normalizedFormat(const QString &suffix)
+{
+    if (suffix == "JPG" || suffix == "JPE") {
+        return "JPEG";
+    }
+    if (suffix == "TIF") {
+        return "TIFF";
+    }
+    return suffix;
+}
+
+// Кадров больше этого числа статистика не касается: длинная анимация
+// почти всегда повторяет одни и те же цвета
+const int MaxStatFrames = 1000;
+
+// Статистика по всем кадрам. Декодирование последовательное (кадр GIF
+// дорисовывается поверх предыдущего), а подсчёт по готовому кадру уходит
+// в общий пул и идёт параллельно с декодированием следующего.
+// Кадров в памяти не больше, чем потоков в пуле.
+PixelStats framesStats(QImageReader &reader, const QImage &first, int frameCount)
+{
+    QThreadPool *pool = QThreadPool::globalInstance();
+    int inFlight = qMax(1, pool->maxThreadCount());
+    QSemaphore budget(inFlight);
+    QMutex mutex;
+    PixelStats total;
+    bool merged = false;
+
+    // Число различных цветов по кадрам не складывается, берётся наибольшее
+    auto work = [&](const QImage &frame) {
+        PixelStats stats = PixelStats::compute(frame);
+        QMutexLocker locker(&mutex);
+        if (!merged) {
+            total = stats;
+            merged = true;
+        } else {
+            total.grayscale = total.grayscale && stats.grayscale;
+            total.alphaUsed = total.alphaUsed || stats.alphaUsed;
+            total.uniqueColors = qMax(total.uniqueColors, stats.uniqueColors);
+            total.complete = total.complete && stats.complete;
+            for (int c = 0; c < PixelStats::ChannelCount; ++c) {
+                for (int level = 0; level < 256; ++level) {
+                    total.histograms[c][level] += stats.histograms[c][level];
+                }
+                total.effectiveBits[c] = qMax(total.effectiveBits[c], stats.effectiveBits[c]);
+            }
+        }
+        locker.unlock();
+        budget.release();
+    };
+
+    // Анимация читается подряд, страницы TIFF - переходом к следующей
+    bool animation = reader.supportsAnimation();
+    QImage image = first;
+    for (int i = 0; i < qMin(frameCount, MaxStatFrames); ++i) {
+        if (i > 0) {
+            if (!animation && !reader.jumpToNextImage()) {
+                break;
+            }
+            if (!reader.read(&image)) {
+                break;
+            }
+        }
+        budget.acquire();
+        if (!pool->tryStart([&work, image]() { work(image); })) {
+            work(image);
+        }
+    }
+    budget.acquire(inFlight);
+    return total;
+}
+
+ImageInfo analyzeContents(const QString &filePath, const AnalysisOptions &options)
+{
+    AnalysisProfiler *profiler = options.profiler;
+
+    ImageInfo info;
+    info.filePath = filePath;
+    {
+        StageTimer timer(profiler, AnalysisProfiler::StatStage, filePath);
+        QFileInfo fileInfo(filePath);
+        info.format = fileInfo.suffix().toUpper();
+        info.fileSize = fileInfo.size();
+    }
+
+    // Быстрый путь: всё нужное лежит в заголовке, пиксели не читаются
+    ImageHeader &header = info.header;
+    bool haveHeader;
+    {
+        StageTimer timer(profiler, AnalysisProfiler::HeaderStage, filePath);
+        haveHeader = ImageHeaders::read(filePath, header, &info.metadata, &info.png, &info.animation);
+    }
+    if (haveHeader) {
+        info.actualFormat = ImageHeaders::formatName(header.format);
+        info.size = QSize(header.width, header.height);
+        // У снимков с камеры JFIF обычно нет, плотность записана только в EXIF
+        info.dpi = header.dpi > 0 ? header.dpi : info.metadata.dpi;
+        info.depth = header.depth;
+        info.colorCount = header.paletteSize;
+        info.hasAlpha = header.hasAlpha;
+        info.grayscale = header.grayscale;
+        info.frameCount = header.frameCount;
+        info.animated = header.format == ImageHeader::Gif && header.frameCount > 1;
+        if (!options.pixelStats) {
+            return info;
+        }
+
+        // Огромные несжатые изображения не декодируются целиком
+        qint64 pixels = qint64(header.width) * header.height;
+        if (options.sampleBudget > 0 && pixels > qint64(options.sampleBudget) * PixelSampler::MinOversampling) {
+            StageTimer timer(profiler, AnalysisProfiler::PixelStage, filePath);
+            if (PixelSampler::estimate(filePath, options.sampleBudget, info)) {
+                return info;
+            }
+        }
+    }
+
+    QImageReader reader(filePath);
+    bool canRead;
+    QImage::Format pixelFormat = QImage::Format_Invalid;
+    {
+        StageTimer timer(profiler, AnalysisProfiler::ProbeStage, filePath);
+        canRead = reader.canRead();
+        if (canRead && !options.pixelStats) {
+            pixelFormat = reader.imageFormat();
+        }
+    }
+    if (!canRead && haveHeader) {
+        // Формат без плагина Qt (например, PCX): остаются сведения из заголовка
+        return info;
+    }
+    if (!canRead) {
+        qDebug() << "Не удалось прочитать файл:" << filePath;
+        info.status = ImageInfo::ReadError;
+        return info;
+    }
+
+    if (!haveHeader) {
+        info.actualFormat = QString::fromLatin1(reader.format()).toUpper();
+        info.size = reader.size();
+        info.animated = reader.supportsAnimation();
+    }
+
+    // Формат без собственного разбора: формат пикселей плагин знает по заголовку
+    if (!options.pixelStats && pixelFormat != QImage::Format_Invalid) {
+        QPixelFormat pf = QImage::toPixelFormat(pixelFormat);
+        info.depth = pf.bitsPerPixel();
+        info.hasAlpha = pf.alphaUsage() == QPixelFormat::UsesAlpha;
+        info.grayscale = pf.colorModel() == QPixelFormat::Grayscale;
+        return info;
+    }
+
+    QImage image;
+    bool decoded;
+    {
+        StageTimer timer(profiler, AnalysisProfiler::DecodeStage, filePath);
+        decoded = reader.read(&image);
+    }
+    if (!decoded) {
+        qDebug() << "Ошибка загрузки изображения:" << filePath;
+        info.status = ImageInfo::LoadError;
+        return info;
+    }
+
+    // DPI и глубина из заголовка точнее, чем у декодированного QImage
+    if (!haveHeader) {
+        info.dpi = (image.dotsPerMeterX() > 0 && image.dotsPerMeterY() > 0) ? image.dotsPerMeterX() / 39.3701 : 0;
+        info.depth = image.depth();
+    }
+    // Один проход вместо isGrayscale(), а прозрачность - по самим пикселям,
+    // а не по флагу формата. Средний и основные цвета - по первому кадру
+    StageTimer timer(profiler, AnalysisProfiler::PixelStage, filePath);
+    PixelStats stats = info.frameCount > 1 ? framesStats(reader, image, info.frameCount) : PixelStats::compute(image);
+    info.colorCount = image.colorCount();
+    info.hasAlpha = stats.alphaUsed;
+    info.grayscale = stats.grayscale;
+    info.uniqueColors = stats.uniqueColors;
+    info.effectiveBits = stats.colorBits();
+    info.colors = ColorSummary::compute(image);
+    info.pixelStats = true;
+
+    return info;
+}
+
+}
+
+ImageInfo ImageAnalysis::analyzeFile(const QString &filePath, const AnalysisOptions &options)
+{
+    StageTimer timer(options.profiler, AnalysisProfiler::FileStage, filePath);
+    ImageInfo info = analyzeContents(filePath, options);
+
+    // Файлы с чужим расширением встречаются часто, формат берётся по сигнатуре
+    info.formatMismatch = !info.actualFormat.isEmpty() && info.actualFormat != normalizedFormat(info.format);
+
+    // Отдельное декодирование сразу в 32x32, даже если изображение уже
+    // декодировано целиком: хэш не зависит от того, запрошена ли статистика
+    if (options.perceptualHash && info.status == ImageInfo::Ok) {
+        StageTimer hashTimer(options.profiler, AnalysisProfiler::HashStage, filePath);
+        info.perceptualHash = PerceptualHash::compute(filePath, info.dHash, info.pHash);
+    }
+    return info;
+}
+
+QDataStream &operator<<(QDataStream &out, const ImageInfo &info)
+{
+    const ImageHeader &header = info.header;
+    out << info.filePath << qint32(info.status) << info.format << info.actualFormat << info.formatMismatch
+        << info.fileSize << info.size << qint32(info.dpi) << qint32(info.depth) << qint32(info.colorCount)
+        << qint32(info.frameCount) << info.hasAlpha << info.grayscale << info.animated << info.pixelStats
+        << qint32(info.uniqueColors) << qint32(info.effectiveBits) << info.sampledPixels
+        << qint32(info.sampleBudget) << qint32(info.uniqueColorsError);
+    const ColorSummary &colors = info.colors;
+    out << colors.mean << colors.dominant << colors.dominantShares;
+    for (quint8 share : colors.hueHistogram) {
+        out << share;
+    }
+    out << info.perceptualHash << info.dHash << info.pHash;
+    const FrameSummary &animation = info.animation;
+    out << qint32(animation.frames) << animation.duration << qint32(animation.minDelay) << qint32(animation.maxDelay)
+        << qint32(animation.loopCount) << qint32(animation.localPalettes) << qint32(animation.partialFrames)
+        << qint32(animation.reducedPages) << animation.dataSize;
+    const ImageMetadata &metadata = info.metadata;
+    out << qint32(metadata.orientation) << metadata.make << metadata.model << metadata.captureTime
+        << qint32(metadata.dpi) << metadata.thumbnailOffset << metadata.thumbnailSize
+        << qint32(metadata.thumbnailWidth) << qint32(metadata.thumbnailHeight) << metadata.exifSize
+        << metadata.xmpSize << metadata.iccSize << metadata.iccColorSpace << metadata.iccDescription;
+    const PngInfo &png = info.png;
+    out << qint32(png.bitDepth) << qint32(png.colorType) << png.interlaced << qint32(png.chunks)
+        << qint32(png.chunkCount) << qint32(png.idatCount) << png.idatSize << png.rawSize << qint32(png.gamma)
+        << png.metadataSize << png.trailingSize;
+    out << qint32(header.format) << qint32(header.compression) << qint32(header.compressionCode)
+        << qint32(header.width) << qint32(header.height) << qint32(header.depth) << qint32(header.dpi)
+        << qint32(header.paletteSize) << qint32(header.frameCount) << header.interlaced << header.progressive
+        << header.lossless << qint32(header.lzwCodeSize) << header.hasAlpha << header.grayscale
+        << qint32(header.quality) << header.qualityExact << qint32(header.chromaSubsampling) << header.optimizedHuffman;
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, ImageInfo &info)
+{
+    ImageHeader &header = info.header;
+    qint32 status, dpi, depth, colorCount, frameCount, uniqueColors, effectiveBits, sampleBudget, uniqueColorsError;
+    in >> info.filePath >> status >> info.format >> info.actualFormat >> info.formatMismatch
+       >> info.fileSize >> info.size >> dpi >> depth >> colorCount
+       >> frameCount >> info.hasAlpha >> info.grayscale >> info.animated >> info.pixelStats
+       >> uniqueColors >> effectiveBits >> info.sampledPixels >> sampleBudget >> uniqueColorsError;
+    info.status = ImageInfo::Status(status);
+    info.dpi = dpi;
+    info.depth = depth;
+    info.colorCount = colorCount;
+    info.frameCount = frameCount;
+    info.uniqueColors = uniqueColors;
+    info.effectiveBits = effectiveBits;
+    info.sampleBudget = sampleBudget;
+    info.uniqueColorsError = uniqueColorsError;
+    ColorSummary &colors = info.colors;
+    in >> colors.mean >> colors.dominant >> colors.dominantShares;
+    for (quint8 &share : colors.hueHistogram) {
+        in >> share;
+    }
+    in >> info.perceptualHash >> info.dHash >> info.pHash;
+    FrameSummary &animation = info.animation;
+    qint32 frames, minDelay, maxDelay, loopCount, localPalettes, partialFrames, reducedPages;
+    in >> frames >> animation.duration >> minDelay >> maxDelay >> loopCount >> localPalettes >> partialFrames
+       >> reducedPages >> animation.dataSize;
+    animation.frames = frames;
+    animation.minDelay = minDelay;
+    animation.maxDelay = maxDelay;
+    animation.loopCount = loopCount;
+    animation.localPalettes = localPalettes;
+    animation.partialFrames = partialFrames;
+    animation.reducedPages = reducedPages;
+    ImageMetadata &metadata = info.metadata;
+    qint32 orientation, metadataDpi, thumbnailWidth, thumbnailHeight;
+    in >> orientation >> metadata.make >> metadata.model >> metadata.captureTime
+       >> metadataDpi >> metadata.thumbnailOffset >> metadata.thumbnailSize
+       >> thumbnailWidth >> thumbnailHeight >> metadata.exifSize
+       >> metadata.xmpSize >> metadata.iccSize >> metadata.iccColorSpace >> metadata.iccDescription;
+    metadata.orientation = orientation;
+    metadata.dpi = metadataDpi;
+    metadata.thumbnailWidth = thumbnailWidth;
+    metadata.thumbnailHeight = thumbnailHeight;
+    PngInfo &png = info.png;
+    qint32 bitDepth, colorType, chunks, chunkCount, idatCount, gamma;
+    in >> bitDepth >> colorType >> png.interlaced >> chunks >> chunkCount >> idatCount >> png.idatSize
+       >> png.rawSize >> gamma >> png.metadataSize >> png.trailingSize;
+    png.bitDepth = bitDepth;
+    png.colorType = colorType;
+    png.chunks = chunks;
+    png.chunkCount = chunkCount;
+    png.idatCount = idatCount;
+    png.gamma = gamma;
+
+    qint32 format, compression, compressionCode, width, height, headerDepth, headerDpi, paletteSize,
+        headerFrames, lzwCodeSize;
+    in >> format >> compression >> compressionCode >> width >> height >> headerDepth >> headerDpi
+       >> paletteSize >> headerFrames >> header.interlaced >> header.progressive
+       >> header.lossless >> lzwCodeSize >> header.hasAlpha >> header.grayscale;
+    qint32 quality, chromaSubsampling;
+    in >> quality >> header.qualityExact >> chromaSubsampling >> header.optimizedHuffman;
+    header.quality = quality;
+    header.chromaSubsampling = chromaSubsampling;
+    header.format = ImageHeader::Format(format);
+    header.compression = ImageHeader::Compression(compression);
+    header.compressionCode = compressionCode;
+    header.width = width;
+    header.height = height;
+    header.depth = headerDepth;
+    header.dpi = headerDpi;
+    header.paletteSize = paletteSize;
+    header.frameCount = headerFrames;
+    header.lzwCodeSize = lzwCodeSize;
+    return in;
+}
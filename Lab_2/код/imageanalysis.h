@@ -0,0 +1,79 @@
+#ifndef IMAGEANALYSIS_H
+#define IMAGEANALYSIS_H
+
+#include <QString>
+#include <QSize>
+#include <QDataStream>
+#include "imageheader.h"
+#include "colorsummary.h"
+
+class AnalysisProfiler;
+
+// Результат анализа одного файла. Только данные, без виджетов,
+// поэтому заполняется в рабочих потоках.
+struct ImageInfo
+{
+    enum Status { Ok, ReadError, LoadError };
+
+    QString filePath;
+    Status status = Ok;
+    QString format;        // расширение файла в верхнем регистре
+    QString actualFormat;  // формат по содержимому, пусто если не распознан
+    bool formatMismatch = false;
+    qint64 fileSize = 0;
+    QSize size;
+    int dpi = 0;
+    int depth = 0;
+    int colorCount = 0;
+    int frameCount = 1;        // кадры GIF или страницы TIFF
+    FrameSummary animation;    // проход по кадрам, если их больше одного
+    ImageHeader header;        // как записано в файле; format == Unknown, если не разобран
+    ImageMetadata metadata;    // EXIF, XMP и ICC, разобранные вместе с заголовком
+    PngInfo png;               // чанки PNG; isNull() для остальных форматов
+    bool hasAlpha = false;
+    bool grayscale = false;
+    bool animated = false;
+    bool pixelStats = false;   // grayscale и hasAlpha посчитаны по пикселям, по всем кадрам
+    int uniqueColors = 0;      // различных цветов по пикселям
+    int effectiveBits = 0;     // реально используемых бит на канал
+    qint64 sampledPixels = 0;  // 0 - посчитано по всем пикселям, иначе размер выборки
+    int sampleBudget = 0;      // запрошенный размер выборки
+    int uniqueColorsError = 0; // половина 95% интервала для оценки числа цветов
+    ColorSummary colors;       // средний и основные цвета, вместе со статистикой по пикселям
+    bool perceptualHash = false;   // dHash и pHash посчитаны
+    quint64 dHash = 0;
+    quint64 pHash = 0;
+};
+
+struct AnalysisOptions
+{
+    // Полное декодирование нужно только для статистики по пикселям,
+    // остальное берётся из заголовка файла
+    bool pixelStats = false;
+
+    // Для изображений больше sampleBudget пикселей статистика оценивается
+    // по выборке, если строки можно читать без декодирования; 0 - всегда точно
+    int sampleBudget = 0;
+
+    // Перцептивные хэши для поиска похожих, по уменьшенному декодированию
+    bool perceptualHash = false;
+
+    // Повторный анализ только изменившихся файлов
+    bool useCache = true;
+    bool hashContents = false;   // сверять ещё и хэш содержимого, а не только размер и время
+
+    // Замер времени по этапам, если задан
+    AnalysisProfiler *profiler = nullptr;
+};
+
+// Сериализация для постоянного кэша
+QDataStream &operator<<(QDataStream &out, const ImageInfo &info);
+QDataStream &operator>>(QDataStream &in, ImageInfo &info);
+
+namespace ImageAnalysis
+{
+    // Потокобезопасно: использует только QImageReader, QImage и разбор заголовков
+    ImageInfo analyzeFile(const QString &filePath, const AnalysisOptions &options = AnalysisOptions());
+}
+
+#endif // IMAGEANALYSIS_H
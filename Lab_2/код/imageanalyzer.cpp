@@ -1,7 +1,7 @@
 #include "imageanalyzer.h"
 
 ImageAnalyzer::ImageAnalyzer(QWidget *parent)
-    : QMainWindow(parent)
+    : QMainWindow(parent), scanStarted(0)
 {
     QWidget *centralWidget = new QWidget(this);
     setCentralWidget(centralWidget);
@@ -17,6 +17,65 @@ ImageAnalyzer::ImageAnalyzer(QWidget *parent)
     analyzeButton = new QPushButton("Анализировать", this);
     analyzeButton->setEnabled(false);
 
+    // Без галочки читаются только заголовки файлов, пиксели не декодируются
+    pixelStatsCheck = new QCheckBox("Статистика по пикселям", this);
+    pixelStatsCheck->setToolTip(
+        "Полностью декодировать изображения,<br>"
+        "чтобы определить цветовую модель<br>"
+        "по самим пикселям. Заметно медленнее."
+        );
+
+    // Хэши считаются по уменьшенной копии, поэтому дёшевы и без статистики по пикселям
+    similarCheck = new QCheckBox("Искать похожие", this);
+    similarCheck->setToolTip(
+        "Считать перцептивные хэши изображений<br>"
+        "и после анализа объединять в группы<br>"
+        "копии, пересжатые и уменьшенные версии."
+        );
+
+    // Огромные несжатые TIFF и BMP оцениваются по выборке строк
+    sampleSpin = new QSpinBox(this);
+    sampleSpin->setRange(0, 100000);
+    sampleSpin->setSingleStep(100);
+    sampleSpin->setSuffix(" тыс. пикс.");
+    sampleSpin->setSpecialValueText("Все пиксели");
+    sampleSpin->setToolTip(
+        "Размер выборки для статистики по пикселям.<br>"
+        "Несжатые TIFF и BMP крупнее выборки<br>"
+        "не декодируются целиком: статистика<br>"
+        "оценивается с доверием 95%."
+        );
+
+    // Результаты прошлых запусков: заново читаются только изменившиеся файлы
+    cacheCheck = new QCheckBox("Кэш", this);
+    cacheCheck->setChecked(true);
+    cacheCheck->setToolTip(
+        "Брать результаты из кэша для файлов,<br>"
+        "у которых не изменились размер<br>"
+        "и время изменения."
+        );
+
+    // После обхода папки новые и изменённые файлы анализируются сами
+    watchCheck = new QCheckBox("Следить за папкой", this);
+    watchCheck->setToolTip(
+        "Отслеживать изменения в выбранной папке<br>"
+        "и заново анализировать только новые<br>"
+        "и изменённые файлы.<br>"
+        "Замечаются созданные, скопированные<br>"
+        "и переименованные файлы; перезапись файла<br>"
+        "на месте папку не меняет и может<br>"
+        "остаться незамеченной."
+        );
+
+    // Время по этапам: сводка в строке состояния, подробности в подсказке к ней
+    profileCheck = new QCheckBox("Замер времени", this);
+    profileCheck->setToolTip(
+        "Замерять время каждого этапа анализа<br>"
+        "и сохранять трассировку для chrome://tracing."
+        );
+    traceButton = new QPushButton("Трассировка...", this);
+    traceButton->setEnabled(false);
+
     folderPath = new QLineEdit(this);
     folderPath->setReadOnly(true);
     folderPath->setPlaceholderText("Выберите папку или файлы с изображениями...");
@@ -26,74 +85,38 @@ ImageAnalyzer::ImageAnalyzer(QWidget *parent)
     controlLayout->addWidget(selectFolderButton);
     controlLayout->addWidget(selectFilesButton);
     controlLayout->addWidget(clearButton);
+    controlLayout->addWidget(pixelStatsCheck);
+    controlLayout->addWidget(sampleSpin);
+    controlLayout->addWidget(similarCheck);
+    controlLayout->addWidget(cacheCheck);
+    controlLayout->addWidget(watchCheck);
+    controlLayout->addWidget(profileCheck);
+    controlLayout->addWidget(traceButton);
     controlLayout->addWidget(analyzeButton);
 
     // Splitter для разделения списка файлов и таблицы
     QSplitter *splitter = new QSplitter(Qt::Horizontal, this);
 
     // Список файлов
-    fileList = new QListWidget(this);
+    imageFiles = new FileListModel(this);
+    fileList = new QListView(this);
+    fileList->setModel(imageFiles);
+    fileList->setUniformItemSizes(true);
     fileList->setMaximumWidth(300);
 
-    // Таблица результатов
-    table = new QTableWidget(this);
-    table->setColumnCount(6);
-    table->setHorizontalHeaderLabels(QStringList()
-                                     << "Имя файла" << "Размер (px)" << "Разрешение (DPI)"
-                                     << "Глубина цвета" << "Сжатие" << "Дополнительная информация");
-
-    // Устанавливаем tooltip'ы для заголовков столбцов
-    table->horizontalHeaderItem(1)->setToolTip(
-        "<b>Размер изображения</b><br>"
-        "<p>Ширина и высота изображения<br>"
-        "в пикселях.</p>"
-        );
-
-    table->horizontalHeaderItem(2)->setToolTip(
-        "<b>Разрешение (DPI)</b><p>"
-        "Единица измерения разрешения изображения,<br>"
-        "указывающая, сколько точек (пикселей)<br>"
-        "будет напечатано на одном дюйме.<br>"
-        "Чем выше значение DPI, тем более<br>"
-        "детализированным и четким будет<br>"
-        "распечатанное изображение.</p>"
-        );
-
-    table->horizontalHeaderItem(3)->setToolTip(
-        "<b>Глубина цвета</b><p>"
-        "Количество бит, используемых для<br>"
-        "представления цвета каждого пикселя<br>"
-        "в изображении.<br>"
-        "Чем выше глубина цвета, тем больше<br>"
-        "уникальных цветов может отобразить<br>"
-        "изображение или монитор.</p>"
-        );
-
-    table->horizontalHeaderItem(4)->setToolTip(
-        "Алгоритмы, которыми происходит сжатие<br>"
-        "(Уменьшение размера файла)<br>"
-        "• <b>Без потерь</b> - PNG, GIF, PCX<br>"
-        "• <b>С потерями</b> - JPEG<br>"
-        "• <b>Без сжатия</b> - BMP"
-        );
-
-    table->horizontalHeaderItem(5)->setToolTip(
-        "<b>Размер файла</b><p>"
-        "Количество КБ, которое занимает<br>"
-        "файл на диске.</p><p>"
-        "<b>Поддержка прозрачности</b></p><p>"
-        "Возможность просмотра объектов<br>"
-        "сквозь другие объекты</p>"
-        "<p><b>Цветовая модель</b></p>"
-        "<p>Способ представления цветов<br>"
-        "в виде числовых значений:<br>"
-        "• <b>цветное</b><br>"
-        "• <b>чёрно-белое</b><br></p>"
-        );
+    // Таблица результатов: данные в модели, текст ячеек собирается при отрисовке
+    results = new ResultModel(this);
+    thumbnails = new ThumbnailService(this);
+    if (thumbnails->open()) {
+        results->setThumbnails(thumbnails);
+    }
+    table = new QTableView(this);
+    table->setModel(results);
 
     // Настройка внешнего вида таблицы
     table->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
     table->horizontalHeader()->setStretchLastSection(true);
+    table->verticalHeader()->setSectionResizeMode(QHeaderView::Interactive);
     table->setSelectionBehavior(QAbstractItemView::SelectRows);
     table->setEditTriggers(QAbstractItemView::NoEditTriggers);
     table->setWordWrap(true);
@@ -106,6 +129,12 @@ ImageAnalyzer::ImageAnalyzer(QWidget *parent)
     table->setColumnWidth(2, 120);
     table->setColumnWidth(3, 120);
     table->setColumnWidth(4, 120);
+    table->setColumnWidth(5, 110);
+    table->setColumnWidth(6, 200);
+    table->setColumnWidth(7, 140);
+    table->setColumnWidth(8, 160);
+    table->setColumnWidth(9, 130);
+    table->setColumnWidth(10, 130);
 
     splitter->addWidget(fileList);
     splitter->addWidget(table);
@@ -129,32 +158,94 @@ ImageAnalyzer::ImageAnalyzer(QWidget *parent)
     connect(selectFilesButton, SIGNAL(clicked()), this, SLOT(selectFiles()));
     connect(clearButton, SIGNAL(clicked()), this, SLOT(clearFiles()));
     connect(analyzeButton, SIGNAL(clicked()), this, SLOT(analyzeImages()));
+    connect(traceButton, SIGNAL(clicked()), this, SLOT(exportTrace()));
+
+    // Высота строк подбирается только для видимых строк
+    connect(table->verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(resizeVisibleRows()));
+    connect(table->horizontalHeader(), SIGNAL(sectionResized(int,int,int)), this, SLOT(resizeVisibleRows()));
+
+    // Миниатюры видимых строк заказываются, когда прокрутка и вставка пачек затихли
+    prefetchTimer = new QTimer(this);
+    prefetchTimer->setSingleShot(true);
+    prefetchTimer->setInterval(300);
+    connect(prefetchTimer, SIGNAL(timeout()), this, SLOT(prefetchThumbnails()));
+
+    // Анализ в пуле потоков, результаты приходят пачками в порядке списка
+    runner = new AnalysisRunner(this);
+    if (cache.open()) {
+        runner->setCache(&cache);
+    }
+    connect(runner, SIGNAL(resultsReady(QList<ImageInfo>)), this, SLOT(onResultsReady(QList<ImageInfo>)));
+    connect(runner, SIGNAL(progress(int,int)), this, SLOT(onAnalysisProgress(int,int)));
+    connect(runner, SIGNAL(finished(bool)), this, SLOT(onAnalysisFinished(bool)));
+
+    // Обход папки с подпапками идёт в фоне, найденные файлы сразу попадают в список
+    scanner = new DirectoryScanner(this);
+    connect(scanner, SIGNAL(filesFound(QStringList)), this, SLOT(onFilesFound(QStringList)));
+    connect(scanner, SIGNAL(finished(int)), this, SLOT(onScanFinished(int)));
+
+    // Повторный анализ отдельных файлов заменяет их строки в таблице. Кэш
+    // не подключается: он сбрасывается на диск в конце анализа и не должен
+    // меняться, пока идёт полный анализ
+    updater = new AnalysisRunner(this);
+    connect(updater, SIGNAL(resultsReady(QList<ImageInfo>)), this, SLOT(onUpdatesReady(QList<ImageInfo>)));
+
+    watcher = new FolderWatcher(this);
+    connect(watcher, SIGNAL(filesChanged(QStringList)), this, SLOT(onFilesChanged(QStringList)));
+    connect(watchCheck, SIGNAL(toggled(bool)), this, SLOT(toggleWatch(bool)));
+
+    // Группы похожих ищутся в фоне по хэшам из таблицы
+    duplicates = new DuplicateFinder(this);
+    connect(duplicates, SIGNAL(groupsFound(QList<QList<int>>)), this, SLOT(onDuplicatesFound(QList<QList<int>>)));
 
     setWindowTitle("Анализатор графических файлов");
     setMinimumSize(1200, 700);
 }
 
-ImageAnalyzer::~ImageAnalyzer() {}
+ImageAnalyzer::~ImageAnalyzer()
+{
+    // Рабочие потоки должны завершиться раньше, чем будет закрыт кэш
+    delete runner;
+    delete updater;
+    delete duplicates;
+}
 
 void ImageAnalyzer::selectFolder()
 {
     QString folder = QFileDialog::getExistingDirectory(this, "Выберите папку с изображениями");
     if (!folder.isEmpty()) {
+        watcher->stop();
+        currentFolder = folder;
+        scanStarted = QDateTime::currentMSecsSinceEpoch();
         folderPath->setText(folder);
+        selectFolderButton->setEnabled(false);
+        statusLabel->setText("Поиск файлов...");
+        scanner->start(folder);
+    }
+}
 
-        QStringList filters;
-        filters << "*.jpg" << "*.jpeg" << "*.gif" << "*.tif" << "*.tiff"
-                << "*.bmp" << "*.png" << "*.pcx";
-
-        QDir dir(folder);
-        QFileInfoList files = dir.entryInfoList(filters, QDir::Files);
+void ImageAnalyzer::onFilesFound(const QStringList &batch)
+{
+    QStringList added = imageFiles->addFiles(batch);
 
-        for (const QFileInfo &fileInfo : files) {
-            addImageFile(fileInfo.absoluteFilePath());
-        }
+    // Анализ, запущенный до конца обхода, получает новые файлы сразу
+    if (runner->isRunning()) {
+        runner->append(int(added.count()));
+    } else {
+        analyzeButton->setEnabled(imageFiles->count() > 0);
+        statusLabel->setText(QString("Найдено файлов: %1...").arg(imageFiles->count()));
+    }
+}
 
-        analyzeButton->setEnabled(!imageFiles.isEmpty());
-        statusLabel->setText(QString("Найдено файлов: %1").arg(imageFiles.count()));
+void ImageAnalyzer::onScanFinished(int total)
+{
+    Q_UNUSED(total);
+    runner->closeInput();
+    toggleWatch(watchCheck->isChecked());
+    if (!runner->isRunning()) {
+        selectFolderButton->setEnabled(true);
+        analyzeButton->setEnabled(imageFiles->count() > 0);
+        statusLabel->setText(QString("Найдено файлов: %1").arg(imageFiles->count()));
     }
 }
 
@@ -168,216 +259,243 @@ void ImageAnalyzer::selectFiles()
         );
 
     if (!files.isEmpty()) {
-        for (const QString &file : files) {
-            addImageFile(file);
-        }
+        // Отдельные файлы не отслеживаются
+        watcher->stop();
+        currentFolder.clear();
+        imageFiles->addFiles(files);
 
         folderPath->setText(QString("Выбрано файлов: %1").arg(files.count()));
-        analyzeButton->setEnabled(!imageFiles.isEmpty());
-        statusLabel->setText(QString("Всего файлов: %1").arg(imageFiles.count()));
+        analyzeButton->setEnabled(imageFiles->count() > 0);
+        statusLabel->setText(QString("Всего файлов: %1").arg(imageFiles->count()));
     }
 }
 
 void ImageAnalyzer::clearFiles()
 {
-    imageFiles.clear();
-    fileList->clear();
-    table->setRowCount(0);
+    scanner->cancel();
+    watcher->stop();
+    currentFolder.clear();
+    pendingChanges.clear();
+    updater->cancel();
+    duplicates->cancel();
+    imageFiles->clear();
+    results->clear();
     folderPath->clear();
     analyzeButton->setEnabled(false);
     statusLabel->setText("Список файлов очищен");
 }
 
-void ImageAnalyzer::addImageFile(const QString &filePath)
+void ImageAnalyzer::analyzeImages()
 {
-    if (!imageFiles.contains(filePath)) {
-        imageFiles.append(filePath);
-        QFileInfo fileInfo(filePath);
-        fileList->addItem(fileInfo.fileName());
+    // Во время анализа кнопка работает как "Отменить"
+    if (runner->isRunning()) {
+        runner->cancel();
+        analyzeButton->setEnabled(false);
+        statusLabel->setText("Отмена анализа...");
+        return;
     }
-}
 
-void ImageAnalyzer::analyzeImages()
-{
-    if (imageFiles.isEmpty()) {
+    if (imageFiles->count() == 0) {
         QMessageBox::warning(this, "Ошибка", "Нет файлов для анализа");
         return;
     }
 
-    table->setRowCount(0);
+    updater->cancel();
+    duplicates->cancel();
+    pendingChanges.clear();
+    results->clear();
     progressBar->setVisible(true);
-    progressBar->setRange(0, imageFiles.count());
+    progressBar->setRange(0, imageFiles->count());
     progressBar->setValue(0);
 
-    analyzeButton->setEnabled(false);
-    selectFolderButton->setEnabled(false);
-    selectFilesButton->setEnabled(false);
-    clearButton->setEnabled(false);
-
-    for (int i = 0; i < imageFiles.count(); ++i) {
-        analyzeImage(imageFiles[i]);
-        progressBar->setValue(i + 1);
-        qApp->processEvents();
-        table->resizeRowToContents(i);
+    setControlsEnabled(false);
+    analyzeButton->setText("Отменить");
+    statusLabel->setText("Анализ...");
+
+    AnalysisOptions options;
+    options.pixelStats = pixelStatsCheck->isChecked();
+    options.perceptualHash = similarCheck->isChecked();
+    options.useCache = cacheCheck->isChecked();
+    options.sampleBudget = sampleSpin->value() * 1000;
+    if (profileCheck->isChecked()) {
+        profiler.reset();
+        options.profiler = &profiler;
     }
+    results->setProfiler(options.profiler);
+    statusLabel->setToolTip(QString());
+    lastOptions = options;
+    // Новые файлы обхода добавляются в конец списка, runner берёт их по индексу
+    runner->start(imageFiles->count(), [this](int i) { return imageFiles->path(i); }, options, scanner->isRunning());
+}
 
-    progressBar->setVisible(false);
-    analyzeButton->setEnabled(true);
-    selectFolderButton->setEnabled(true);
-    selectFilesButton->setEnabled(true);
-    clearButton->setEnabled(true);
-    statusLabel->setText(QString("Анализ завершен. Обработано файлов: %1").arg(imageFiles.count()));
+void ImageAnalyzer::onResultsReady(const QList<ImageInfo> &batch)
+{
+    StageTimer timer(lastOptions.profiler, AnalysisProfiler::InsertStage);
+    results->append(batch);
+    resizeVisibleRows();
 }
 
-void ImageAnalyzer::analyzeImage(const QString &filePath)
+void ImageAnalyzer::toggleWatch(bool enabled)
 {
-    QFileInfo fileInfo(filePath);
-    QString fileName = fileInfo.fileName();
-    QString format = fileInfo.suffix().toUpper();
-    qint64 fileSize = fileInfo.size();
-
-    QImageReader reader(filePath);
-    if (!reader.canRead()) {
-        qDebug() << "Не удалось прочитать файл:" << filePath;
-
-        int row = table->rowCount();
-        table->insertRow(row);
-        table->setItem(row, 0, new QTableWidgetItem(fileName));
-        table->setItem(row, 1, new QTableWidgetItem("Ошибка чтения"));
-        table->setItem(row, 2, new QTableWidgetItem("N/A"));
-        table->setItem(row, 3, new QTableWidgetItem("N/A"));
-        table->setItem(row, 4, new QTableWidgetItem(getCompressionInfo(format)));
-        table->setItem(row, 5, new QTableWidgetItem("Формат не поддерживается"));
-        return;
+    if (!enabled) {
+        watcher->stop();
+    } else if (!currentFolder.isEmpty() && !scanner->isRunning() && !watcher->isWatching()) {
+        watcher->start(currentFolder, scanStarted);
     }
+}
 
-    QSize size = reader.size();
-
-    // Загрузка изображения только для получения глубины цвета и DPI
-    QImage image;
-    if (!reader.read(&image)) {
-        qDebug() << "Ошибка загрузки изображения:" << filePath;
-
-        int row = table->rowCount();
-        table->insertRow(row);
-        table->setItem(row, 0, new QTableWidgetItem(fileName));
-        table->setItem(row, 1, new QTableWidgetItem(QString("%1 x %2").arg(size.width()).arg(size.height())));
-        table->setItem(row, 2, new QTableWidgetItem("N/A"));
-        table->setItem(row, 3, new QTableWidgetItem("N/A"));
-        table->setItem(row, 4, new QTableWidgetItem(getCompressionInfo(format)));
-        table->setItem(row, 5, new QTableWidgetItem("Ошибка загрузки данных"));
+void ImageAnalyzer::onFilesChanged(const QStringList &files)
+{
+    thumbnails->invalidate(files);
+    imageFiles->addFiles(files);
+    analyzeButton->setEnabled(imageFiles->count() > 0);
+
+    // Пока анализа не было, новые файлы только попадают в список
+    if (results->rowCount() == 0 && !runner->isRunning()) {
+        statusLabel->setText(QString("Всего файлов: %1").arg(imageFiles->count()));
         return;
     }
 
-    // Получение DPI
-    int dpi = (image.dotsPerMeterX() > 0 &&  image.dotsPerMeterY() > 0) ? image.dotsPerMeterX() / 39.3701 : 0;
-    int row = table->rowCount();
-    table->insertRow(row);
-
-    // Имя файла
-    QTableWidgetItem *fileNameItem = new QTableWidgetItem(fileName);
-
-    QString tooltipHtml = QString(
-                              "<b>%1</b><br>"
-                              "<font color='gray'>%2</font><br><br>"
-                              "<img src='file:///%3' width='150' style='border: 1px solid #ccc;'>"
-                              ).arg(fileName).arg(filePath).arg(filePath);
+    // Иначе строка файла, ещё не выданного полным анализом, появилась бы дважды
+    if (runner->isRunning()) {
+        pendingChanges.append(files);
+        return;
+    }
+    reanalyze(files);
+}
 
-    fileNameItem->setToolTip(tooltipHtml);
+void ImageAnalyzer::reanalyze(const QStringList &files)
+{
+    if (files.isEmpty()) {
+        return;
+    }
+    if (updater->isRunning()) {
+        updateFiles.append(files);
+        updater->append(int(files.count()));
+    } else {
+        updateFiles = files;
+        updater->start(int(files.count()), [this](int i) { return updateFiles.at(i); }, lastOptions);
+    }
+}
 
-    // Размер изображения
-    QTableWidgetItem *sizeItem = new QTableWidgetItem(QString("%1 x %2").arg(size.width()).arg(size.height()));
+void ImageAnalyzer::onUpdatesReady(const QList<ImageInfo> &batch)
+{
+    results->update(batch);
+    resizeVisibleRows();
+    statusLabel->setText(QString("Обновлено файлов: %1").arg(batch.count()));
 
-    // Разрешение DPI
-    QTableWidgetItem *dpiItem = new QTableWidgetItem(QString("%1").arg(dpi));
+    // Изменившийся файл мог войти в группу или выйти из неё
+    if (lastOptions.perceptualHash && !runner->isRunning()) {
+        findDuplicates();
+    }
+}
 
-    // Глубина цвета
-    QTableWidgetItem *depthItem = new QTableWidgetItem(getColorDepthInfo(image, format));
+void ImageAnalyzer::resizeVisibleRows()
+{
+    int first = table->rowAt(0);
+    if (first < 0) {
+        return;
+    }
 
-    // Сжатие
-    QTableWidgetItem *compressionItem = new QTableWidgetItem(getCompressionInfo(format));
+    // Граница проверяется после каждой подгонки: строки становятся выше,
+    // и в окно помещается меньше строк
+    int bottom = table->viewport()->height();
+    for (int row = first; row < results->rowCount() && table->rowViewportPosition(row) < bottom; ++row) {
+        table->resizeRowToContents(row);
+    }
+    prefetchTimer->start();
+}
 
-    // Дополнительная информация
-    QString extraInfo = getExtraInfo(reader, image, format, fileSize);
-    QTableWidgetItem *extraItem = new QTableWidgetItem(extraInfo);
+void ImageAnalyzer::prefetchThumbnails()
+{
+    int first = table->rowAt(0);
+    if (first < 0) {
+        return;
+    }
 
-    table->setItem(row, 0, fileNameItem);
-    table->setItem(row, 1, sizeItem);
-    table->setItem(row, 2, dpiItem);
-    table->setItem(row, 3, depthItem);
-    table->setItem(row, 4, compressionItem);
-    table->setItem(row, 5, extraItem);
+    int bottom = table->viewport()->height();
+    for (int row = first; row < results->rowCount() && table->rowViewportPosition(row) < bottom; ++row) {
+        thumbnails->request(results->filePath(row));
+    }
 }
 
-QString ImageAnalyzer::getExtraInfo(QImageReader &reader, const QImage &image, const QString &format, qint64 fileSize)
+void ImageAnalyzer::onAnalysisProgress(int done, int total)
 {
-    QStringList info;
+    progressBar->setMaximum(total);
+    progressBar->setValue(done);
+    statusLabel->setText(QString("Обработано файлов: %1 из %2").arg(done).arg(total));
+}
 
-    info << QString("Размер файла: %1 КБ").arg(fileSize / 1024);
+void ImageAnalyzer::onAnalysisFinished(bool cancelled)
+{
+    progressBar->setVisible(false);
+    analyzeButton->setText("Анализировать");
+    setControlsEnabled(true);
 
-    if (reader.supportsAnimation()) {
-        info << "Анимация: поддерживается";
-    }
+    QStringList changes;
+    changes.swap(pendingChanges);
+    reanalyze(changes);
 
-    if (image.hasAlphaChannel()) {
-        info << "Прозрачность: да";
+    if (cancelled) {
+        statusLabel->setText(QString("Анализ отменён. Обработано файлов: %1").arg(results->rowCount()));
     } else {
-        info << "Прозрачность: нет";
+        statusLabel->setText(QString("Анализ завершен. Обработано файлов: %1 (из кэша: %2)")
+                                 .arg(results->rowCount()).arg(runner->cacheHits()));
     }
 
-    if (image.isGrayscale()) {
-        info << "Цветовая модель: градации серого";
-    } else {
-        info << "Цветовая модель: цветное";
+    if (lastOptions.profiler) {
+        statusLabel->setText(statusLabel->text() + ". " + profiler.summary());
+        statusLabel->setToolTip(profiler.details());
+        traceButton->setEnabled(true);
     }
 
-    // Специфичная информация для форматов
-    if (format == "GIF") {
-        int colors = image.colorCount();
-        if (colors > 0) {
-            info << QString("Цветов в палитре: %1").arg(colors);
-        }
+    if (lastOptions.perceptualHash && !cancelled) {
+        findDuplicates();
     }
-    return info.join("\n");
 }
 
-QString ImageAnalyzer::getCompressionInfo(const QString &format)
+void ImageAnalyzer::findDuplicates()
+{
+    QVector<int> rows;
+    QVector<quint64> pHashes;
+    QVector<quint64> dHashes;
+    results->perceptualHashes(rows, pHashes, dHashes);
+    duplicates->start(rows, pHashes, dHashes);
+}
+
+void ImageAnalyzer::onDuplicatesFound(const QList<QList<int>> &groups)
 {
-    if (format == "JPG" || format == "JPEG") {
-        return "JPEG (с потерями)";
-    } else if (format == "PNG") {
-        return "Deflate (без потерь)";
-    } else if (format == "GIF") {
-        return "LZW (без потерь)";
-    } else if (format == "TIFF" || format == "TIF") {
-        return "LZW/JPEG/None";
-    } else if (format == "BMP") {
-        return "Без сжатия";
-    } else if (format == "PCX") {
-        return "RLE (без потерь)";
+    results->setGroups(groups);
+
+    int files = 0;
+    for (const QList<int> &group : groups) {
+        files += group.count();
     }
-    return "Неизвестно";
+    statusLabel->setText(statusLabel->text() + QString(". Групп похожих: %1 (файлов: %2)").arg(groups.count()).arg(files));
 }
 
-QString ImageAnalyzer::getColorDepthInfo(const QImage &image, const QString &format)
+void ImageAnalyzer::exportTrace()
 {
-    int depth = image.depth();
-    QString info = QString("%1 бит").arg(depth);
-
-    // Только базовая информация, которую можно получить из QImage
-    if (depth == 1) {
-        info += " (монохром)";
-    } else if (depth == 8) {
-        if (image.colorCount() > 0) {
-            info += " (индексированные цвета)";
-        } else {
-            info += " (градации серого)";
-        }
-    } else if (depth == 24) {
-        info += " (True Color)";
-    } else if (depth == 32) {
-        info += image.hasAlphaChannel() ? " (True Color + Alpha)" : " (True Color)";
+    QString fileName = QFileDialog::getSaveFileName(this, "Сохранить трассировку", "trace.json",
+                                                    "Трассировка Chrome (*.json)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    if (!profiler.exportTrace(fileName)) {
+        QMessageBox::warning(this, "Ошибка", "Не удалось сохранить трассировку");
     }
+}
 
-    return info;
+void ImageAnalyzer::setControlsEnabled(bool enabled)
+{
+    analyzeButton->setEnabled(true);
+    selectFolderButton->setEnabled(enabled && !scanner->isRunning());
+    selectFilesButton->setEnabled(enabled);
+    clearButton->setEnabled(enabled);
+    pixelStatsCheck->setEnabled(enabled);
+    similarCheck->setEnabled(enabled);
+    sampleSpin->setEnabled(enabled);
+    cacheCheck->setEnabled(enabled);
+    profileCheck->setEnabled(enabled);
+    traceButton->setEnabled(enabled && lastOptions.profiler);
 }
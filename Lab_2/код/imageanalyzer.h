@@ -2,7 +2,7 @@
 #define IMAGEANALYZER_H
 
 #include <QMainWindow>
-#include <QTableWidget>
+#include <QTableView>
 #include <QPushButton>
 #include <QLineEdit>
 #include <QLabel>
@@ -10,6 +10,7 @@
 #include <QDir>
 #include <QImageReader>
 #include <QHeaderView>
+#include <QScrollBar>
 #include <QFileInfo>
 #include <QMessageBox>
 #include <QDebug>
@@ -17,30 +18,65 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QApplication>
-#include <QListWidget>
+#include <QListView>
 #include <QSplitter>
+#include <QCheckBox>
+#include <QSpinBox>
+#include <QTimer>
+#include <QDateTime>
+#include "analysisrunner.h"
+#include "resultmodel.h"
+#include "analysiscache.h"
+#include "directoryscanner.h"
+#include "filelistmodel.h"
+#include "thumbnailservice.h"
+#include "folderwatcher.h"
+#include "analysisprofiler.h"
+#include "duplicatefinder.h"
 
 class ImageAnalyzer : public QMainWindow
 {
     Q_OBJECT
 
 private:
-    QTableWidget *table;
-    QListWidget *fileList;
+    QTableView *table;
+    ResultModel *results;
+    QListView *fileList;
+    FileListModel *imageFiles;
     QPushButton *selectFolderButton;
     QPushButton *selectFilesButton;
     QPushButton *clearButton;
     QPushButton *analyzeButton;
+    QCheckBox *pixelStatsCheck;
+    QCheckBox *similarCheck;
+    QCheckBox *cacheCheck;
+    QSpinBox *sampleSpin;
+    QCheckBox *watchCheck;
+    QCheckBox *profileCheck;
+    QPushButton *traceButton;
     QLineEdit *folderPath;
     QLabel *statusLabel;
     QProgressBar *progressBar;
-    QStringList imageFiles;
+    AnalysisRunner *runner;
+    AnalysisRunner *updater;
+    DirectoryScanner *scanner;
+    ThumbnailService *thumbnails;
+    QTimer *prefetchTimer;
+    FolderWatcher *watcher;
+    DuplicateFinder *duplicates;
+    AnalysisCache cache;
+    AnalysisProfiler profiler;
 
-    void analyzeImage(const QString &filePath);
-    QString getExtraInfo(QImageReader &reader, const QImage &image, const QString &format, qint64 fileSize);
-    void addImageFile(const QString &filePath);
-    QString getCompressionInfo(const QString &format);
-    QString getColorDepthInfo(const QImage &image, const QString &format);
+    QString currentFolder;
+    qint64 scanStarted;          // мс с начала эпохи, изменения после него отдаёт наблюдатель
+    AnalysisOptions lastOptions;
+    QStringList pendingChanges;  // изменения, пришедшие во время полного анализа
+    QStringList updateFiles;     // входной список updater
+
+    void reanalyze(const QStringList &files);
+    void findDuplicates();
+
+    void setControlsEnabled(bool enabled);
 
 public:
     ImageAnalyzer(QWidget *parent = nullptr);
@@ -51,6 +87,18 @@ private slots:
     void selectFiles();
     void clearFiles();
     void analyzeImages();
+    void onResultsReady(const QList<ImageInfo> &batch);
+    void onAnalysisProgress(int done, int total);
+    void onAnalysisFinished(bool cancelled);
+    void onFilesFound(const QStringList &batch);
+    void onScanFinished(int total);
+    void resizeVisibleRows();
+    void prefetchThumbnails();
+    void toggleWatch(bool enabled);
+    void onFilesChanged(const QStringList &files);
+    void onUpdatesReady(const QList<ImageInfo> &batch);
+    void exportTrace();
+    void onDuplicatesFound(const QList<QList<int>> &groups);
 
 };
 
@@ -0,0 +1,1289 @@
+#include "imageheader.h"
+#include <QFile>
+#include <QSet>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+inline quint16 be16(const uchar *p) { return quint16(p[0] << 8 | p[1]); }
+inline quint32 be32(const uchar *p) { return quint32(p[0]) << 24 | quint32(p[1]) << 16 | quint32(p[2]) << 8 | p[3]; }
+inline quint16 le16(const uchar *p) { return quint16(p[1] << 8 | p[0]); }
+inline quint32 le32(const uchar *p) { return quint32(p[3]) << 24 | quint32(p[2]) << 16 | quint32(p[1]) << 8 | p[0]; }
+
+constexpr quint32 chunkType(const char (&name)[5])
+{
+    return quint32(uchar(name[0])) << 24 | quint32(uchar(name[1])) << 16 | quint32(uchar(name[2])) << 8 | uchar(name[3]);
+}
+
+int dpiFromDotsPerMeter(quint32 dpm)
+{
+    return int(std::lround(dpm / 39.3701));
+}
+
+// Палитра из записей по stride байт, порядок каналов в записи не важен
+bool isGrayPalette(const uchar *entries, int count, int stride)
+{
+    for (int i = 0; i < count; ++i) {
+        const uchar *e = entries + i * stride;
+        if (e[0] != e[1] || e[1] != e[2]) {
+            return false;
+        }
+    }
+    return count > 0;
+}
+
+bool parsePng(const uchar *data, qint64 size, ImageHeader &header)
+{
+    // Сигнатура 8 байт, первым всегда идёт IHDR
+    if (size < 33 || std::memcmp(data, "\x89PNG\r\n\x1a\n", 8) != 0 || be32(data + 12) != chunkType("IHDR")) {
+        return false;
+    }
+
+    header.format = ImageHeader::Png;
+    header.compression = ImageHeader::DeflateCompression;
+    header.width = int(be32(data + 16));
+    header.height = int(be32(data + 20));
+
+    int bitDepth = data[24];
+    int colorType = data[25];
+    static const int channels[7] = { 1, 0, 3, 1, 2, 0, 4 };
+    header.depth = bitDepth * (colorType < 7 ? channels[colorType] : 0);
+    header.grayscale = colorType == 0 || colorType == 4;
+    header.hasAlpha = colorType == 4 || colorType == 6;
+    header.interlaced = data[28] == 1;
+
+    // PLTE, tRNS и pHYs обязаны стоять до первого IDAT
+    qint64 pos = 8;
+    while (pos + 12 <= size) {
+        quint32 length = be32(data + pos);
+        quint32 type = be32(data + pos + 4);
+        const uchar *chunk = data + pos + 8;
+        if (length > quint32(size - pos - 12) || type == chunkType("IDAT")) {
+            break;
+        }
+
+        if (type == chunkType("PLTE")) {
+            header.paletteSize = int(length / 3);
+            header.grayscale = isGrayPalette(chunk, header.paletteSize, 3);
+        } else if (type == chunkType("tRNS")) {
+            header.hasAlpha = true;
+        } else if (type == chunkType("pHYs") && length >= 9 && chunk[8] == 1) {
+            header.dpi = dpiFromDotsPerMeter(be32(chunk));
+        }
+        pos += 12 + qint64(length);
+    }
+    return true;
+}
+
+// Базовые таблицы квантования JPEG (приложение K), от которых libjpeg
+// масштабирует свои, в естественном порядке
+const quint8 StdLuminanceTable[64] = {
+    16,  11,  10,  16,  24,  40,  51,  61,
+    12,  12,  14,  19,  26,  58,  60,  55,
+    14,  13,  16,  24,  40,  57,  69,  56,
+    14,  17,  22,  29,  51,  87,  80,  62,
+    18,  22,  37,  56,  68, 109, 103,  77,
+    24,  35,  55,  64,  81, 104, 113,  92,
+    49,  64,  78,  87, 103, 121, 120, 101,
+    72,  92,  95,  98, 112, 100, 103,  99
+};
+const quint8 StdChrominanceTable[64] = {
+    17,  18,  24,  47,  99,  99,  99,  99,
+    18,  21,  26,  66,  99,  99,  99,  99,
+    24,  26,  56,  99,  99,  99,  99,  99,
+    47,  66,  99,  99,  99,  99,  99,  99,
+    99,  99,  99,  99,  99,  99,  99,  99,
+    99,  99,  99,  99,  99,  99,  99,  99,
+    99,  99,  99,  99,  99,  99,  99,  99,
+    99,  99,  99,  99,  99,  99,  99,  99
+};
+
+// Позиция в блоке 8x8 для k-го значения в порядке зигзага (так таблицы лежат в DQT)
+const quint8 ZigzagOrder[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+// Длины кодов стандартных таблиц Хаффмана (приложение K): DC и AC, яркость и цветность
+const quint8 StdHuffmanCounts[2][2][16] = {
+    { { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 },
+      { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 } },
+    { { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D },
+      { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 } }
+};
+
+// libjpeg строит таблицы для качества q масштабом 5000/q (q < 50) или
+// 200 - 2q процентов от базовых. Перебираются все 100 значений, оценка -
+// ближайшее по сумме квадратов отклонений: это 100 x 128 операций на файл.
+// Таблицы других кодеров (Photoshop, камеры) дают только приближённую оценку
+int estimateQuality(const quint16 *luminance, const quint16 *chrominance, int limit, bool &exact)
+{
+    int best = 0;
+    qint64 bestError = -1;
+    for (int quality = 1; quality <= 100; ++quality) {
+        int scale = quality < 50 ? 5000 / quality : 200 - 2 * quality;
+        qint64 error = 0;
+        for (int k = 0; k < 64; ++k) {
+            int position = ZigzagOrder[k];
+            int expected = qBound(1, (StdLuminanceTable[position] * scale + 50) / 100, limit);
+            error += qint64(luminance[k] - expected) * (luminance[k] - expected);
+            if (chrominance) {
+                expected = qBound(1, (StdChrominanceTable[position] * scale + 50) / 100, limit);
+                error += qint64(chrominance[k] - expected) * (chrominance[k] - expected);
+            }
+        }
+        if (bestError < 0 || error < bestError) {
+            bestError = error;
+            best = quality;
+        }
+    }
+    exact = bestError == 0;
+    return best;
+}
+
+bool parseJpeg(const uchar *data, qint64 size, ImageHeader &header)
+{
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+        return false;
+    }
+
+    header.format = ImageHeader::Jpeg;
+    header.compression = ImageHeader::JpegCompression;
+    bool haveFrame = false;
+    quint16 tables[4][64];
+    int definedTables = 0;
+    int wideTables = 0;        // таблицы с 16-битными значениями
+    int lumaTable = -1;
+    int chromaTable = -1;
+    qint64 pos = 2;
+    while (pos + 4 <= size && data[pos] == 0xFF) {
+        uchar marker = data[pos + 1];
+        if (marker == 0xFF) {
+            ++pos;  // байты-заполнители перед маркером
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+            pos += 2;  // маркеры без длины
+            continue;
+        }
+        if (marker == 0xDA || marker == 0xD9) {
+            break;  // дальше идут сжатые данные
+        }
+
+        int length = be16(data + pos + 2);
+        const uchar *segment = data + pos + 4;
+        if (length < 2 || pos + 2 + length > size) {
+            break;
+        }
+
+        if (marker == 0xE0 && length >= 16 && std::memcmp(segment, "JFIF\0", 5) == 0) {
+            // Единицы плотности: 1 - точки на дюйм, 2 - точки на сантиметр
+            int units = segment[7];
+            int density = be16(segment + 8);
+            if (units == 1) {
+                header.dpi = density;
+            } else if (units == 2) {
+                header.dpi = int(std::lround(density * 2.54));
+            }
+        } else if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC
+                   && length >= 8) {
+            int precision = segment[0];
+            int components = segment[5];
+            header.height = be16(segment + 1);
+            header.width = be16(segment + 3);
+            header.depth = precision * components;
+            header.grayscale = components == 1;
+            header.compressionCode = marker;
+            // Младшие два бита номера SOF: 0/1 - последовательный, 2 - прогрессивный, 3 - без потерь
+            header.progressive = (marker & 3) == 2;
+            header.lossless = (marker & 3) == 3;
+            haveFrame = true;
+
+            // Компоненты по 3 байта: номер, множители дискретизации (H << 4 | V), номер таблицы
+            if (components >= 1 && length >= 8 + components * 3) {
+                lumaTable = segment[8] & 3;
+            }
+            if (components >= 3 && length >= 8 + components * 3) {
+                int luma = segment[7];
+                int chroma = segment[10];
+                chromaTable = segment[11] & 3;
+                if ((chroma >> 4) > 0 && (chroma & 15) > 0) {
+                    header.chromaSubsampling = (((luma >> 4) / (chroma >> 4)) << 4) | ((luma & 15) / (chroma & 15));
+                }
+            }
+        } else if (marker == 0xDB) {
+            // Несколько таблиц подряд: байт точности и номера, затем 64 значения в порядке зигзага
+            qint64 offset = 0;
+            while (offset < length - 2) {
+                int wide = segment[offset] >> 4;
+                int id = segment[offset] & 3;
+                if (offset + 1 + 64 * (wide ? 2 : 1) > length - 2) {
+                    break;
+                }
+                const uchar *values = segment + offset + 1;
+                for (int k = 0; k < 64; ++k) {
+                    tables[id][k] = wide ? be16(values + 2 * k) : values[k];
+                }
+                definedTables |= 1 << id;
+                wideTables = wide ? wideTables | (1 << id) : wideTables & ~(1 << id);
+                offset += 1 + 64 * (wide ? 2 : 1);
+            }
+        } else if (marker == 0xC4) {
+            // Сравниваются только длины кодов: у оптимизированных таблиц (jpegtran -optimize,
+            // прогрессивные JPEG) они почти никогда не совпадают со стандартными
+            qint64 offset = 0;
+            while (offset + 17 <= length - 2) {
+                int tableClass = (segment[offset] >> 4) & 1;
+                int id = segment[offset] & 1;
+                const uchar *counts = segment + offset + 1;
+                if (std::memcmp(counts, StdHuffmanCounts[tableClass][id], 16) != 0) {
+                    header.optimizedHuffman = true;
+                }
+                int symbols = 0;
+                for (int i = 0; i < 16; ++i) {
+                    symbols += counts[i];
+                }
+                offset += 17 + symbols;
+            }
+        }
+        pos += 2 + length;
+    }
+
+    // Таблицы без потерь не квантуют; SOF обычно идёт после DQT, поэтому оценка в конце
+    if (haveFrame && !header.lossless && lumaTable >= 0 && (definedTables & (1 << lumaTable))) {
+        bool withChroma = chromaTable >= 0 && (definedTables & (1 << chromaTable));
+        bool wide = (wideTables & (1 << lumaTable)) || (withChroma && (wideTables & (1 << chromaTable)));
+        header.quality = estimateQuality(tables[lumaTable], withChroma ? tables[chromaTable] : nullptr,
+                                         wide ? 32767 : 255, header.qualityExact);
+    }
+    return haveFrame;
+}
+
+ImageHeader::Compression bmpCompression(quint32 code)
+{
+    switch (code) {
+    case 0:
+    case 3:
+    case 6:  return ImageHeader::NoCompression;       // BI_RGB и битовые маски
+    case 1:
+    case 2:  return ImageHeader::RleCompression;
+    case 4:  return ImageHeader::JpegCompression;
+    case 5:  return ImageHeader::DeflateCompression;  // PNG внутри BMP
+    default: return ImageHeader::OtherCompression;
+    }
+}
+
+bool parseBmp(const uchar *data, qint64 size, ImageHeader &header)
+{
+    if (size < 26 || data[0] != 'B' || data[1] != 'M') {
+        return false;
+    }
+
+    quint32 infoSize = le32(data + 14);
+    int bitCount;
+    int paletteStride = 4;
+    quint32 colorsUsed = 0;
+    quint32 compression = 0;
+    if (infoSize == 12) {
+        // Заголовок OS/2 BITMAPCOREHEADER
+        header.width = le16(data + 18);
+        header.height = le16(data + 20);
+        bitCount = le16(data + 24);
+        paletteStride = 3;
+    } else if (infoSize >= 40 && size >= 54) {
+        // Отрицательная высота - строки сверху вниз; у INT_MIN модуля в qint32 нет
+        qint32 height = qint32(le32(data + 22));
+        if (height == std::numeric_limits<qint32>::min()) {
+            return false;
+        }
+        header.width = qint32(le32(data + 18));
+        header.height = qAbs(height);
+        bitCount = le16(data + 28);
+        compression = le32(data + 30);
+        header.dpi = dpiFromDotsPerMeter(le32(data + 38));
+        colorsUsed = le32(data + 46);
+
+        // Маска альфа-канала идёт после масок RGB: в заголовке V3 и новее
+        // либо сразу за BITMAPINFOHEADER при BI_ALPHABITFIELDS
+        bool bitfields = compression == 3 || compression == 6;
+        bool hasAlphaMask = infoSize >= 56 || compression == 6;
+        if (bitfields && hasAlphaMask && (bitCount == 16 || bitCount == 32) && size >= 70) {
+            header.hasAlpha = le32(data + 66) != 0;
+        }
+    } else {
+        return false;
+    }
+
+    header.format = ImageHeader::Bmp;
+    header.depth = bitCount;
+    header.compression = bmpCompression(compression);
+    header.compressionCode = int(compression);
+    // У BI_JPEG и BI_PNG bitCount равен 0: палитры нет
+    if (bitCount >= 1 && bitCount <= 8) {
+        header.paletteSize = colorsUsed ? int(qMin<quint32>(colorsUsed, 256)) : 1 << bitCount;
+        qint64 paletteOffset = 14 + qint64(infoSize);
+        if (paletteOffset + qint64(header.paletteSize) * paletteStride <= size) {
+            header.grayscale = isGrayPalette(data + paletteOffset, header.paletteSize, paletteStride);
+        }
+    }
+    return true;
+}
+
+// Пропуск цепочки подблоков GIF, возвращает позицию после нулевого терминатора
+qint64 skipGifSubBlocks(const uchar *data, qint64 size, qint64 pos)
+{
+    while (pos < size && data[pos] != 0) {
+        pos += 1 + data[pos];
+    }
+    return pos + 1;
+}
+
+bool parseGif(const uchar *data, qint64 size, ImageHeader &header)
+{
+    if (size < 13 || (std::memcmp(data, "GIF87a", 6) != 0 && std::memcmp(data, "GIF89a", 6) != 0)) {
+        return false;
+    }
+
+    header.format = ImageHeader::Gif;
+    header.compression = ImageHeader::LzwCompression;
+    header.width = le16(data + 6);
+    header.height = le16(data + 8);
+    header.frameCount = 0;
+
+    uchar flags = data[10];
+    qint64 pos = 13;
+    if (flags & 0x80) {
+        header.paletteSize = 2 << (flags & 7);
+        header.depth = (flags & 7) + 1;
+        if (pos + header.paletteSize * 3 <= size) {
+            header.grayscale = isGrayPalette(data + pos, header.paletteSize, 3);
+        }
+        pos += header.paletteSize * 3;
+    }
+
+    // Кадры считаются проходом по блокам без распаковки LZW
+    while (pos < size && data[pos] != 0x3B) {
+        if (data[pos] == 0x21 && pos + 2 <= size) {
+            uchar label = data[pos + 1];
+            pos += 2;
+            // Прозрачность задаётся в расширении Graphic Control перед кадром
+            if (label == 0xF9 && pos + 2 <= size && data[pos] >= 4 && (data[pos + 1] & 1)) {
+                header.hasAlpha = true;
+            }
+            pos = skipGifSubBlocks(data, size, pos);
+        } else if (data[pos] == 0x2C && pos + 10 <= size) {
+            uchar localFlags = data[pos + 9];
+            pos += 10;
+            if (localFlags & 0x80) {
+                if (header.frameCount == 0 && !(flags & 0x80)) {
+                    // Только локальная палитра у первого кадра
+                    header.paletteSize = 2 << (localFlags & 7);
+                    header.depth = (localFlags & 7) + 1;
+                }
+                pos += qint64(2 << (localFlags & 7)) * 3;
+            }
+            if (header.frameCount == 0 && pos < size) {
+                header.interlaced = localFlags & 0x40;
+                header.lzwCodeSize = data[pos];
+            }
+            ++header.frameCount;
+            pos = skipGifSubBlocks(data, size, pos + 1);  // байт минимального размера кода LZW
+        } else {
+            break;
+        }
+    }
+    return true;
+}
+
+// Значения в TIFF записаны в порядке байт, указанном в заголовке файла
+struct TiffReader
+{
+    const uchar *data;
+    qint64 size;
+    bool bigEndian;
+
+    quint16 u16(qint64 pos) const { return bigEndian ? be16(data + pos) : le16(data + pos); }
+    quint32 u32(qint64 pos) const { return bigEndian ? be32(data + pos) : le32(data + pos); }
+
+    // Первое значение записи IFD: короткие значения лежат прямо в записи, длинные - по смещению
+    quint32 value(qint64 entry, int index = 0) const
+    {
+        quint16 type = u16(entry + 2);
+        quint32 count = u32(entry + 4);
+        int typeSize = (type == 3 || type == 8) ? 2 : (type == 4 || type == 9) ? 4 : (type == 1 || type == 6) ? 1 : 0;
+        if (typeSize == 0 || quint32(index) >= count) {
+            return 0;
+        }
+        qint64 pos = quint64(count) * typeSize <= 4 ? entry + 8 : u32(entry + 8);
+        pos += qint64(index) * typeSize;
+        if (pos < 0 || pos + typeSize > size) {
+            return 0;
+        }
+        return typeSize == 2 ? u16(pos) : typeSize == 4 ? u32(pos) : data[pos];
+    }
+
+    double rational(qint64 entry) const
+    {
+        qint64 pos = u32(entry + 8);
+        if (u16(entry + 2) != 5 || pos + 8 > size) {
+            return 0;
+        }
+        quint32 denominator = u32(pos + 4);
+        return denominator ? double(u32(pos)) / denominator : 0;
+    }
+};
+
+ImageHeader::Compression tiffCompression(quint32 code)
+{
+    switch (code) {
+    case 1:     return ImageHeader::NoCompression;
+    case 2:
+    case 3:
+    case 4:     return ImageHeader::CcittCompression;
+    case 5:     return ImageHeader::LzwCompression;
+    case 6:
+    case 7:     return ImageHeader::JpegCompression;
+    case 8:
+    case 32946: return ImageHeader::DeflateCompression;
+    case 32773: return ImageHeader::PackBitsCompression;
+    default:    return ImageHeader::OtherCompression;
+    }
+}
+
+bool parseTiff(const uchar *data, qint64 size, ImageHeader &header)
+{
+    if (size < 8) {
+        return false;
+    }
+    bool bigEndian;
+    if (std::memcmp(data, "II*\0", 4) == 0) {
+        bigEndian = false;
+    } else if (std::memcmp(data, "MM\0*", 4) == 0) {
+        bigEndian = true;
+    } else {
+        return false;
+    }
+
+    TiffReader tiff = { data, size, bigEndian };
+    header.format = ImageHeader::Tiff;
+    header.frameCount = 0;
+
+    // Описание берётся из первого IFD, остальные только считаются как страницы.
+    // IFD может лежать по любому смещению, в том числе раньше предыдущего
+    // (дописанные и перезаписанные каталоги), поэтому от зацикленных
+    // смещений защищает набор пройденных IFD, а не порядок
+    QSet<qint64> visited;
+    qint64 ifd = tiff.u32(4);
+    while (ifd >= 8 && ifd + 2 <= size && header.frameCount < 65536 && !visited.contains(ifd)) {
+        visited.insert(ifd);
+        int entries = tiff.u16(ifd);
+        if (ifd + 2 + qint64(entries) * 12 + 4 > size) {
+            break;
+        }
+
+        if (header.frameCount == 0) {
+            int bitsPerSample = 1;
+            int samplesPerPixel = 1;
+            int photometric = -1;
+            int resolutionUnit = 2;
+            double xResolution = 0;
+            qint64 colorMap = -1;
+            header.compression = ImageHeader::NoCompression;
+            header.compressionCode = 1;
+
+            for (int i = 0; i < entries; ++i) {
+                qint64 entry = ifd + 2 + qint64(i) * 12;
+                switch (tiff.u16(entry)) {
+                case 256: header.width = int(tiff.value(entry)); break;
+                case 257: header.height = int(tiff.value(entry)); break;
+                case 258: bitsPerSample = int(tiff.value(entry)); break;
+                case 259:
+                    header.compressionCode = int(tiff.value(entry));
+                    header.compression = tiffCompression(quint32(header.compressionCode));
+                    break;
+                case 262: photometric = int(tiff.value(entry)); break;
+                case 277: samplesPerPixel = int(tiff.value(entry)); break;
+                case 282: xResolution = tiff.rational(entry); break;
+                case 296: resolutionUnit = int(tiff.value(entry)); break;
+                case 320: colorMap = entry; break;
+                case 338: header.hasAlpha = tiff.value(entry) != 0; break;
+                }
+            }
+
+            header.depth = bitsPerSample * samplesPerPixel;
+            header.grayscale = photometric == 0 || photometric == 1;
+            if (resolutionUnit == 2) {
+                header.dpi = int(std::lround(xResolution));
+            } else if (resolutionUnit == 3) {
+                header.dpi = int(std::lround(xResolution * 2.54));
+            }
+
+            // ColorMap: сначала все красные, затем все зелёные и синие составляющие
+            if (photometric == 3 && colorMap >= 0) {
+                int count = int(qMin<quint32>(tiff.u32(colorMap + 4) / 3, 65536));
+                header.paletteSize = count;
+                bool gray = count > 0;
+                for (int i = 0; i < count && gray; ++i) {
+                    quint32 r = tiff.value(colorMap, i);
+                    gray = r == tiff.value(colorMap, count + i) && r == tiff.value(colorMap, 2 * count + i);
+                }
+                header.grayscale = gray;
+            }
+        }
+
+        ++header.frameCount;
+        ifd = tiff.u32(ifd + 2 + qint64(entries) * 12);
+    }
+    return header.frameCount > 0;
+}
+
+// Кадры GIF: Graphic Control Extension относится к следующему за ним кадру
+bool gifFrames(const uchar *data, qint64 size, QVector<FrameInfo> &frames, int &loopCount)
+{
+    if (size < 13 || (std::memcmp(data, "GIF87a", 6) != 0 && std::memcmp(data, "GIF89a", 6) != 0)) {
+        return false;
+    }
+
+    uchar flags = data[10];
+    qint64 pos = 13;
+    if (flags & 0x80) {
+        pos += qint64(2 << (flags & 7)) * 3;
+    }
+
+    FrameInfo pending;
+    while (pos < size && data[pos] != 0x3B) {
+        if (data[pos] == 0x21 && pos + 2 <= size) {
+            uchar label = data[pos + 1];
+            pos += 2;
+            if (label == 0xF9 && pos + 5 <= size && data[pos] >= 4) {
+                pending.disposal = (data[pos + 1] >> 2) & 7;
+                pending.transparent = data[pos + 1] & 1;
+                pending.delay = le16(data + pos + 2) * 10;
+            } else if (label == 0xFF && pos + 16 <= size && data[pos] == 11
+                       && (std::memcmp(data + pos + 1, "NETSCAPE2.0", 11) == 0
+                           || std::memcmp(data + pos + 1, "ANIMEXTS1.0", 11) == 0)
+                       && data[pos + 12] >= 3 && data[pos + 13] == 1) {
+                loopCount = le16(data + pos + 14);
+            }
+            pos = skipGifSubBlocks(data, size, pos);
+        } else if (data[pos] == 0x2C && pos + 10 <= size) {
+            FrameInfo frame = pending;
+            pending = FrameInfo();
+            frame.left = le16(data + pos + 1);
+            frame.top = le16(data + pos + 3);
+            frame.width = le16(data + pos + 5);
+            frame.height = le16(data + pos + 7);
+            uchar localFlags = data[pos + 9];
+            frame.interlaced = localFlags & 0x40;
+            pos += 10;
+            if (localFlags & 0x80) {
+                frame.paletteSize = 2 << (localFlags & 7);
+                pos += qint64(frame.paletteSize) * 3;
+            }
+
+            // Данные LZW не читаются, складываются только длины подблоков
+            pos += 1;  // минимальный размер кода LZW
+            while (pos < size && data[pos] != 0) {
+                frame.dataSize += data[pos];
+                pos += 1 + data[pos];
+            }
+            pos += 1;
+            frames.append(frame);
+        } else {
+            break;
+        }
+    }
+    return true;
+}
+
+// Страницы TIFF: по IFD, полосы и плитки не читаются, только их длины
+bool tiffFrames(const uchar *data, qint64 size, QVector<FrameInfo> &frames)
+{
+    if (size < 8) {
+        return false;
+    }
+    bool bigEndian;
+    if (std::memcmp(data, "II*\0", 4) == 0) {
+        bigEndian = false;
+    } else if (std::memcmp(data, "MM\0*", 4) == 0) {
+        bigEndian = true;
+    } else {
+        return false;
+    }
+
+    TiffReader tiff = { data, size, bigEndian };
+    QSet<qint64> visited;
+    qint64 ifd = tiff.u32(4);
+    while (ifd >= 8 && ifd + 2 <= size && frames.count() < 65536 && !visited.contains(ifd)) {
+        visited.insert(ifd);
+        int entries = tiff.u16(ifd);
+        if (ifd + 2 + qint64(entries) * 12 + 4 > size) {
+            break;
+        }
+
+        FrameInfo frame;
+        int bitsPerSample = 1;
+        int samplesPerPixel = 1;
+        frame.compressionCode = 1;
+        for (int i = 0; i < entries; ++i) {
+            qint64 entry = ifd + 2 + qint64(i) * 12;
+            switch (tiff.u16(entry)) {
+            case 254: frame.reduced = tiff.value(entry) & 1; break;
+            case 256: frame.width = int(tiff.value(entry)); break;
+            case 257: frame.height = int(tiff.value(entry)); break;
+            case 258: bitsPerSample = int(tiff.value(entry)); break;
+            case 259: frame.compressionCode = int(tiff.value(entry)); break;
+            case 277: samplesPerPixel = int(tiff.value(entry)); break;
+            case 320: frame.paletteSize = int(qMin<quint32>(tiff.u32(entry + 4) / 3, 65536)); break;
+            case 279:   // StripByteCounts
+            case 325: { // TileByteCounts
+                // Длин не больше, чем могло бы поместиться в файле
+                quint32 count = qMin<quint32>(tiff.u32(entry + 4), quint32(qMin<qint64>(size / 2, 1 << 24)));
+                for (quint32 j = 0; j < count; ++j) {
+                    frame.dataSize += tiff.value(entry, int(j));
+                }
+                break;
+            }
+            }
+        }
+        frame.depth = bitsPerSample * samplesPerPixel;
+        frames.append(frame);
+        ifd = tiff.u32(ifd + 2 + qint64(entries) * 12);
+    }
+    return !frames.isEmpty();
+}
+
+// Текст из файла до первого нуля, не длиннее length
+QString latin1Text(const uchar *text, qint64 length)
+{
+    const uchar *end = static_cast<const uchar *>(std::memchr(text, 0, size_t(length)));
+    return QString::fromLatin1(reinterpret_cast<const char *>(text), end ? end - text : length).trimmed();
+}
+
+// Строка ASCII из записи IFD: до 4 байт лежат в самой записи
+QString tiffString(const TiffReader &tiff, qint64 entry)
+{
+    quint32 count = tiff.u32(entry + 4);
+    qint64 pos = count <= 4 ? entry + 8 : tiff.u32(entry + 8);
+    if (tiff.u16(entry + 2) != 2 || count == 0 || pos + count > tiff.size) {
+        return QString();
+    }
+    return latin1Text(tiff.data + pos, count);
+}
+
+// Смещение и длина значения записи IFD из байтов (XMP, ICC в TIFF)
+bool tiffBlock(const TiffReader &tiff, qint64 entry, qint64 &pos, qint64 &length)
+{
+    length = tiff.u32(entry + 4);
+    pos = length <= 4 ? entry + 8 : tiff.u32(entry + 8);
+    return length > 0 && pos + length <= tiff.size;
+}
+
+// Записи IFD целиком внутри блока
+int tiffEntries(const TiffReader &tiff, qint64 ifd)
+{
+    if (ifd < 8 || ifd + 2 > tiff.size) {
+        return 0;
+    }
+    int entries = tiff.u16(ifd);
+    return ifd + 2 + qint64(entries) * 12 + 4 <= tiff.size ? entries : 0;
+}
+
+// Заголовок ICC - 128 байт (цветовое пространство в байтах 16-19), за ним таблица тегов.
+// Описание: в версии 2 - тип desc (ASCII), в версии 4 - mluc (UTF-16BE)
+void parseIcc(const uchar *profile, qint64 size, ImageMetadata &metadata)
+{
+    if (size < 132 || std::memcmp(profile + 36, "acsp", 4) != 0) {
+        return;
+    }
+    metadata.iccColorSpace = latin1Text(profile + 16, 4);
+
+    quint32 tags = be32(profile + 128);
+    for (quint32 i = 0; i < tags && 132 + qint64(i + 1) * 12 <= size; ++i) {
+        const uchar *tag = profile + 132 + qint64(i) * 12;
+        if (be32(tag) != chunkType("desc")) {
+            continue;
+        }
+        qint64 offset = be32(tag + 4);
+        qint64 length = be32(tag + 8);
+        if (offset + length > size || length < 12) {
+            break;
+        }
+        const uchar *desc = profile + offset;
+        if (std::memcmp(desc, "desc", 4) == 0) {
+            metadata.iccDescription = latin1Text(desc + 12, qMin<qint64>(be32(desc + 8), length - 12));
+        } else if (std::memcmp(desc, "mluc", 4) == 0 && length >= 28) {
+            qint64 textLength = be32(desc + 20);
+            qint64 textOffset = be32(desc + 24);
+            if (textOffset + textLength <= length) {
+                QString text;
+                for (qint64 j = 0; j + 1 < textLength; j += 2) {
+                    text += QChar(be16(desc + textOffset + j));
+                }
+                metadata.iccDescription = text.trimmed();
+            }
+        }
+        break;
+    }
+}
+
+// Структура TIFF внутри EXIF (или сам файл TIFF); base - её смещение от начала файла
+void parseExif(const uchar *data, qint64 size, qint64 base, ImageMetadata &metadata)
+{
+    bool bigEndian;
+    if (size >= 8 && std::memcmp(data, "II*\0", 4) == 0) {
+        bigEndian = false;
+    } else if (size >= 8 && std::memcmp(data, "MM\0*", 4) == 0) {
+        bigEndian = true;
+    } else {
+        return;
+    }
+    metadata.exifSize = size;
+
+    TiffReader tiff = { data, size, bigEndian };
+    qint64 ifd0 = tiff.u32(4);
+    qint64 exifIfd = 0;
+    int resolutionUnit = 2;   // по умолчанию дюймы
+    double resolution = 0;
+    QString dateTime;
+    int entries = tiffEntries(tiff, ifd0);
+    for (int i = 0; i < entries; ++i) {
+        qint64 entry = ifd0 + 2 + qint64(i) * 12;
+        qint64 pos, length;
+        switch (tiff.u16(entry)) {
+        case 0x010F: metadata.make = tiffString(tiff, entry); break;
+        case 0x0110: metadata.model = tiffString(tiff, entry); break;
+        case 0x0112: metadata.orientation = int(tiff.value(entry)); break;
+        case 0x011A: resolution = tiff.rational(entry); break;
+        case 0x0128: resolutionUnit = int(tiff.value(entry)); break;
+        case 0x0132: dateTime = tiffString(tiff, entry); break;
+        case 0x8769: exifIfd = tiff.u32(entry + 8); break;
+        case 0x02BC:   // XMP
+            if (tiffBlock(tiff, entry, pos, length)) {
+                metadata.xmpSize = length;
+            }
+            break;
+        case 0x8773:   // ICC
+            if (tiffBlock(tiff, entry, pos, length)) {
+                metadata.iccSize = length;
+                parseIcc(data + pos, length, metadata);
+            }
+            break;
+        }
+    }
+    if (resolutionUnit == 2) {
+        metadata.dpi = int(std::lround(resolution));
+    } else if (resolutionUnit == 3) {
+        metadata.dpi = int(std::lround(resolution * 2.54));
+    }
+
+    entries = tiffEntries(tiff, exifIfd);
+    for (int i = 0; i < entries; ++i) {
+        qint64 entry = exifIfd + 2 + qint64(i) * 12;
+        if (tiff.u16(entry) == 0x9003) {
+            dateTime = tiffString(tiff, entry);
+            break;
+        }
+    }
+    metadata.captureTime = QDateTime::fromString(dateTime, "yyyy:MM:dd HH:mm:ss");
+
+    // Миниатюра описана в IFD1: JPEGInterchangeFormat и его длина
+    entries = tiffEntries(tiff, ifd0);
+    qint64 ifd1 = entries ? tiff.u32(ifd0 + 2 + qint64(entries) * 12) : 0;
+    entries = ifd1 > ifd0 ? tiffEntries(tiff, ifd1) : 0;
+    qint64 offset = 0;
+    qint64 length = 0;
+    for (int i = 0; i < entries; ++i) {
+        qint64 entry = ifd1 + 2 + qint64(i) * 12;
+        if (tiff.u16(entry) == 0x0201) {
+            offset = tiff.value(entry);
+        } else if (tiff.u16(entry) == 0x0202) {
+            length = tiff.value(entry);
+        }
+    }
+    ImageHeader thumbnail;
+    if (offset > 0 && length > 0 && offset + length <= size && parseJpeg(data + offset, length, thumbnail)) {
+        metadata.thumbnailOffset = base + offset;
+        metadata.thumbnailSize = length;
+        metadata.thumbnailWidth = thumbnail.width;
+        metadata.thumbnailHeight = thumbnail.height;
+    }
+}
+
+// APP1 с EXIF или XMP и APP2 с ICC до начала сжатых данных
+void jpegMetadata(const uchar *data, qint64 size, ImageMetadata &metadata)
+{
+    static const char XmpId[] = "http://ns.adobe.com/xap/1.0/";
+    static const char ExtendedXmpId[] = "http://ns.adobe.com/xmp/extension/";
+
+    qint64 pos = 2;
+    while (pos + 4 <= size && data[pos] == 0xFF) {
+        uchar marker = data[pos + 1];
+        if (marker == 0xFF) {
+            ++pos;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+            pos += 2;
+            continue;
+        }
+        if (marker == 0xDA || marker == 0xD9) {
+            break;
+        }
+
+        qint64 length = be16(data + pos + 2) - 2;
+        const uchar *segment = data + pos + 4;
+        if (length < 0 || pos + 4 + length > size) {
+            break;
+        }
+
+        if (marker == 0xE1 && length >= 6 && std::memcmp(segment, "Exif\0", 5) == 0) {
+            if (metadata.exifSize == 0) {
+                parseExif(segment + 6, length - 6, pos + 10, metadata);
+            }
+        } else if (marker == 0xE1 && length >= qint64(sizeof(XmpId)) && std::memcmp(segment, XmpId, sizeof(XmpId)) == 0) {
+            metadata.xmpSize += length - qint64(sizeof(XmpId));
+        } else if (marker == 0xE1 && length >= qint64(sizeof(ExtendedXmpId))
+                   && std::memcmp(segment, ExtendedXmpId, sizeof(ExtendedXmpId)) == 0) {
+            metadata.xmpSize += length - qint64(sizeof(ExtendedXmpId));
+        } else if (marker == 0xE2 && length >= 14 && std::memcmp(segment, "ICC_PROFILE\0", 12) == 0) {
+            // Большой профиль разбит на части; заголовок и теги обычно в первой
+            metadata.iccSize += length - 14;
+            if (segment[12] == 1) {
+                parseIcc(segment + 14, length - 14, metadata);
+            }
+        }
+        pos += 4 + length;
+    }
+}
+
+// Один проход по чанкам PNG до IEND: сводка по чанкам и, если metadata
+// задан, EXIF, XMP и ICC. IDAT пропускаются по длинам, не распаковываются
+bool walkPng(const uchar *data, qint64 size, PngInfo &png, ImageMetadata *metadata)
+{
+    static const char XmpKeyword[] = "XML:com.adobe.xmp";
+
+
+    png = PngInfo();
+    if (size < 33 || std::memcmp(data, "\x89PNG\r\n\x1a\n", 8) != 0 || be32(data + 12) != chunkType("IHDR")) {
+        return false;
+    }
+
+    int width = int(be32(data + 16));
+    int height = int(be32(data + 20));
+    png.bitDepth = data[24];
+    png.colorType = data[25];
+    png.interlaced = data[28] == 1;
+
+    // Распакованный размер: у каждой строки байт фильтра, у Adam7 - 7 проходов со своими строками
+    static const int channels[7] = { 1, 0, 3, 1, 2, 0, 4 };
+    int bitsPerPixel = png.bitDepth * (png.colorType < 7 ? channels[png.colorType] : 0);
+    static const int adam7[7][4] = {
+        { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 }
+    };
+    static const int single[1][4] = { { 0, 0, 1, 1 } };
+    const int (*passes)[4] = png.interlaced ? adam7 : single;
+    for (int i = 0; i < (png.interlaced ? 7 : 1); ++i) {
+        qint64 passWidth = (qint64(width) - passes[i][0] + passes[i][2] - 1) / passes[i][2];
+        qint64 passHeight = (qint64(height) - passes[i][1] + passes[i][3] - 1) / passes[i][3];
+        if (passWidth > 0 && passHeight > 0) {
+            png.rawSize += passHeight * (1 + (passWidth * bitsPerPixel + 7) / 8);
+        }
+    }
+
+    qint64 pos = 8;
+    while (pos + 12 <= size) {
+        quint32 length = be32(data + pos);
+        quint32 type = be32(data + pos + 4);
+        const uchar *chunk = data + pos + 8;
+        if (length > quint32(size - pos - 12)) {
+            break;
+        }
+        ++png.chunkCount;
+        pos += 12 + qint64(length);
+
+        switch (type) {
+        case chunkType("IDAT"):
+            ++png.idatCount;
+            png.idatSize += length;
+            break;
+        case chunkType("gAMA"):
+            png.chunks |= PngInfo::Gamma;
+            png.gamma = length >= 4 ? int(be32(chunk)) : 0;
+            break;
+        case chunkType("iCCP"):
+            png.chunks |= PngInfo::IccProfile;
+            if (metadata) {
+                // Профиль сжат zlib; без распаковки известно только имя
+                metadata->iccSize = length;
+                metadata->iccDescription = latin1Text(chunk, qMin<qint64>(length, 80));
+            }
+            break;
+        case chunkType("pHYs"): png.chunks |= PngInfo::PhysicalSize; break;
+        case chunkType("sRGB"): png.chunks |= PngInfo::Srgb; break;
+        case chunkType("cHRM"): png.chunks |= PngInfo::Chromaticity; break;
+        case chunkType("bKGD"): png.chunks |= PngInfo::Background; break;
+        case chunkType("tRNS"): png.chunks |= PngInfo::Transparency; break;
+        case chunkType("eXIf"):
+            png.chunks |= PngInfo::Exif;
+            if (metadata) {
+                parseExif(chunk, length, chunk - data, *metadata);
+            }
+            break;
+        case chunkType("tEXt"):
+        case chunkType("zTXt"):
+        case chunkType("iTXt"):
+            if (metadata && type == chunkType("iTXt") && length >= sizeof(XmpKeyword)
+                && std::memcmp(chunk, XmpKeyword, sizeof(XmpKeyword)) == 0) {
+                metadata->xmpSize = length;
+            }
+            png.chunks |= PngInfo::Text;
+            png.metadataSize += 12 + qint64(length);
+            break;
+        case chunkType("tIME"):
+            png.chunks |= PngInfo::Time;
+            png.metadataSize += 12 + qint64(length);
+            break;
+        default:
+            // Строчная первая буква - вспомогательный чанк, неизвестный декодеру
+            if ((type >> 24) & 0x20) {
+                png.metadataSize += 12 + qint64(length);
+            }
+            break;
+        }
+        if (type == chunkType("IEND")) {
+            png.trailingSize = size - pos;
+            break;
+        }
+    }
+    return true;
+}
+
+bool parsePcx(const uchar *data, qint64 size, ImageHeader &header)
+{
+    // Заголовок PCX всегда 128 байт; версии 0-5, кодирование 0 или 1 (RLE)
+    if (size < 128 || data[0] != 0x0A || data[1] > 5 || data[2] > 1) {
+        return false;
+    }
+
+    int bitsPerPixel = data[3];
+    int planes = data[65];
+    header.format = ImageHeader::Pcx;
+    header.compression = data[2] == 1 ? ImageHeader::RleCompression : ImageHeader::NoCompression;
+    header.compressionCode = data[2];
+    header.width = le16(data + 8) - le16(data + 4) + 1;
+    header.height = le16(data + 10) - le16(data + 6) + 1;
+    header.dpi = le16(data + 12);
+    header.depth = bitsPerPixel * planes;
+
+    if (bitsPerPixel == 8 && planes == 1 && size >= 128 + 769 && data[size - 769] == 0x0C) {
+        // 256-цветная палитра в конце файла после маркера 0x0C
+        header.paletteSize = 256;
+        header.grayscale = isGrayPalette(data + size - 768, 256, 3);
+    } else if (header.depth <= 4) {
+        // 16-цветная палитра прямо в заголовке
+        header.paletteSize = 1 << header.depth;
+        header.grayscale = isGrayPalette(data + 16, header.paletteSize, 3);
+    }
+    return true;
+}
+
+bool tiffRasterLayout(const uchar *data, qint64 size, RasterLayout &layout)
+{
+    TiffReader tiff = { data, size, data[0] == 'M' };
+    qint64 ifd = tiff.u32(4);
+    if (ifd < 8 || ifd + 2 > size) {
+        return false;
+    }
+    int entries = tiff.u16(ifd);
+    if (ifd + 2 + qint64(entries) * 12 + 4 > size) {
+        return false;
+    }
+
+    int samplesPerPixel = 1;
+    int photometric = -1;
+    int planar = 1;
+    bool eightBit = true;
+    qint64 rowsPerStrip = -1;
+    for (int i = 0; i < entries; ++i) {
+        qint64 entry = ifd + 2 + qint64(i) * 12;
+        switch (tiff.u16(entry)) {
+        case 256: layout.width = int(tiff.value(entry)); break;
+        case 257: layout.height = int(tiff.value(entry)); break;
+        case 258:
+            for (quint32 s = 0; s < tiff.u32(entry + 4) && s < 8; ++s) {
+                eightBit &= tiff.value(entry, int(s)) == 8;
+            }
+            break;
+        case 259: if (tiff.value(entry) != 1) return false; break;
+        case 262: photometric = int(tiff.value(entry)); break;
+        case 273:
+            layout.stripCount = int(tiff.u32(entry + 4));
+            layout.stripOffsetSize = tiff.u16(entry + 2) == 3 ? 2 : 4;
+            layout.stripOffsets = qint64(layout.stripCount) * layout.stripOffsetSize <= 4 ? entry + 8 : tiff.u32(entry + 8);
+            break;
+        case 277: samplesPerPixel = int(tiff.value(entry)); break;
+        case 278: rowsPerStrip = tiff.value(entry); break;
+        case 284: planar = int(tiff.value(entry)); break;
+        case 322: return false;   // плитки
+        case 338: layout.alpha = tiff.value(entry) != 0; break;
+        }
+    }
+
+    if (!eightBit || planar != 1 || layout.stripOffsets < 0 || layout.width <= 0 || layout.height <= 0) {
+        return false;
+    }
+    if ((photometric == 0 || photometric == 1) && samplesPerPixel == 1) {
+        layout.order = RasterLayout::Gray;
+        layout.inverted = photometric == 0;
+    } else if (photometric == 2 && (samplesPerPixel == 3 || samplesPerPixel == 4)) {
+        layout.order = RasterLayout::Rgb;
+        layout.alpha = layout.alpha && samplesPerPixel == 4;
+    } else {
+        return false;
+    }
+
+    layout.bytesPerPixel = samplesPerPixel;
+    layout.stride = qint64(layout.width) * samplesPerPixel;
+    layout.rowsPerStrip = int(rowsPerStrip > 0 && rowsPerStrip < layout.height ? rowsPerStrip : layout.height);
+    layout.bigEndian = tiff.bigEndian;
+    return true;
+}
+
+bool bmpRasterLayout(const uchar *data, qint64 size, RasterLayout &layout)
+{
+    if (size < 54 || le32(data + 14) < 40 || le32(data + 30) != 0) {
+        return false;
+    }
+
+    qint32 height = qint32(le32(data + 22));
+    if (height == std::numeric_limits<qint32>::min()) {
+        return false;
+    }
+    int bitCount = le16(data + 28);
+    layout.width = qint32(le32(data + 18));
+    layout.height = qAbs(height);
+    layout.bottomUp = height > 0;
+    layout.firstRow = le32(data + 10);
+    if (bitCount == 8) {
+        layout.order = RasterLayout::Indexed;
+        quint32 colorsUsed = le32(data + 46);
+        layout.palette = 14 + qint64(le32(data + 14));
+        layout.paletteSize = colorsUsed ? int(qMin<quint32>(colorsUsed, 256)) : 256;
+    } else if (bitCount == 24 || bitCount == 32) {
+        // В BI_RGB четвёртый байт не используется
+        layout.order = RasterLayout::Bgr;
+    } else {
+        return false;
+    }
+
+    layout.bytesPerPixel = bitCount / 8;
+    layout.stride = (qint64(layout.width) * bitCount + 31) / 32 * 4;
+    layout.rowsPerStrip = layout.height;
+    return layout.width > 0 && layout.height > 0;
+}
+}
+
+qint64 RasterLayout::rowOffset(const uchar *data, qint64 size, int y) const
+{
+    if (y < 0 || y >= height) {
+        return -1;
+    }
+
+    qint64 offset;
+    if (stripOffsets < 0) {
+        offset = firstRow + qint64(bottomUp ? height - 1 - y : y) * stride;
+    } else {
+        int strip = y / rowsPerStrip;
+        qint64 entry = stripOffsets + qint64(strip) * stripOffsetSize;
+        if (strip >= stripCount || entry + stripOffsetSize > size) {
+            return -1;
+        }
+        qint64 start = stripOffsetSize == 2 ? (bigEndian ? be16(data + entry) : le16(data + entry))
+                                            : (bigEndian ? be32(data + entry) : le32(data + entry));
+        offset = start + qint64(y % rowsPerStrip) * stride;
+    }
+    return offset + qint64(width) * bytesPerPixel <= size ? offset : -1;
+}
+
+bool ImageHeaders::rasterLayout(const uchar *data, qint64 size, RasterLayout &layout)
+{
+    layout = RasterLayout();
+    if (size < 8) {
+        return false;
+    }
+    if (std::memcmp(data, "II*\0", 4) == 0 || std::memcmp(data, "MM\0*", 4) == 0) {
+        return tiffRasterLayout(data, size, layout);
+    }
+    if (data[0] == 'B' && data[1] == 'M') {
+        return bmpRasterLayout(data, size, layout);
+    }
+    return false;
+}
+
+bool ImageHeaders::frames(const uchar *data, qint64 size, QVector<FrameInfo> &frameList, int *loopCount)
+{
+    frameList.clear();
+    int loops = -1;
+    bool ok = false;
+    if (size >= 8) {
+        if (data[0] == 'G') {
+            ok = gifFrames(data, size, frameList, loops);
+        } else if (data[0] == 'I' || data[0] == 'M') {
+            ok = tiffFrames(data, size, frameList);
+        }
+    }
+    if (loopCount) {
+        *loopCount = loops;
+    }
+    return ok;
+}
+
+bool ImageHeaders::pngChunks(const uchar *data, qint64 size, PngInfo &png)
+{
+    return walkPng(data, size, png, nullptr);
+}
+
+QString ImageMetadata::camera() const
+{
+    if (model.startsWith(make, Qt::CaseInsensitive)) {
+        return model;
+    }
+    return make.isEmpty() ? model : model.isEmpty() ? make : make + ' ' + model;
+}
+
+bool ImageHeaders::parseMetadata(const uchar *data, qint64 size, ImageMetadata &metadata)
+{
+    metadata = ImageMetadata();
+    if (size >= 8 && data[0] == 0xFF && data[1] == 0xD8) {
+        jpegMetadata(data, size, metadata);
+    } else if (size >= 8 && std::memcmp(data, "\x89PNG\r\n\x1a\n", 8) == 0) {
+        PngInfo png;
+        walkPng(data, size, png, &metadata);
+    } else {
+        // У TIFF EXIF - это теги самого файла, поэтому размер блока не считается
+        parseExif(data, size, 0, metadata);
+        metadata.exifSize = 0;
+    }
+    return !metadata.isNull();
+}
+
+FrameSummary ImageHeaders::summarize(const QVector<FrameInfo> &frameList, int canvasWidth, int canvasHeight, int loopCount)
+{
+    FrameSummary summary;
+    summary.frames = int(frameList.count());
+    summary.loopCount = loopCount;
+    for (int i = 0; i < frameList.count(); ++i) {
+        const FrameInfo &frame = frameList[i];
+        summary.duration += frame.delay;
+        summary.minDelay = i == 0 ? frame.delay : qMin(summary.minDelay, frame.delay);
+        summary.maxDelay = qMax(summary.maxDelay, frame.delay);
+        summary.localPalettes += frame.paletteSize > 0;
+        summary.reducedPages += frame.reduced;
+        summary.dataSize += frame.dataSize;
+        if (canvasWidth > 0 && (frame.left > 0 || frame.top > 0 || frame.width < canvasWidth || frame.height < canvasHeight)) {
+            ++summary.partialFrames;
+        }
+    }
+    return summary;
+}
+
+bool ImageHeaders::parse(const uchar *data, qint64 size, ImageHeader &header)
+{
+    header = ImageHeader();
+    if (size < 2) {
+        return false;
+    }
+
+    switch (data[0]) {
+    case 0x89: return parsePng(data, size, header);
+    case 0xFF: return parseJpeg(data, size, header);
+    case 'B':  return parseBmp(data, size, header);
+    case 'G':  return parseGif(data, size, header);
+    case 'I':
+    case 'M':  return parseTiff(data, size, header);
+    case 0x0A: return parsePcx(data, size, header);
+    default:   return false;
+    }
+}
+
+const char *ImageHeaders::formatName(ImageHeader::Format format)
+{
+    switch (format) {
+    case ImageHeader::Bmp:  return "BMP";
+    case ImageHeader::Png:  return "PNG";
+    case ImageHeader::Gif:  return "GIF";
+    case ImageHeader::Jpeg: return "JPEG";
+    case ImageHeader::Tiff: return "TIFF";
+    case ImageHeader::Pcx:  return "PCX";
+    default:                return "";
+    }
+}
+
+const char *ImageHeaders::compressionName(ImageHeader::Compression compression)
+{
+    switch (compression) {
+    case ImageHeader::NoCompression:       return "none";
+    case ImageHeader::RleCompression:      return "rle";
+    case ImageHeader::LzwCompression:      return "lzw";
+    case ImageHeader::DeflateCompression:  return "deflate";
+    case ImageHeader::JpegCompression:     return "jpeg";
+    case ImageHeader::PackBitsCompression: return "packbits";
+    case ImageHeader::CcittCompression:    return "ccitt";
+    default:                               return "other";
+    }
+}
+
+const char *ImageHeaders::subsamplingName(int chromaSubsampling)
+{
+    switch (chromaSubsampling) {
+    case 0x11: return "4:4:4";
+    case 0x21: return "4:2:2";
+    case 0x22: return "4:2:0";
+    case 0x12: return "4:4:0";
+    case 0x41: return "4:1:1";
+    case 0x42: return "4:1:0";
+    default:   return "";
+    }
+}
+
+bool ImageHeaders::read(const QString &filePath, ImageHeader &header, ImageMetadata *metadata, PngInfo *png,
+                        FrameSummary *animation)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        return false;
+    }
+
+    // Отображение в память ленивое: читаются только страницы, которых касается
+    // разбор (заголовки, маркеры JPEG, IFD TIFF), данные пикселей не трогаются
+    uchar *data = file.map(0, file.size());
+    if (!data) {
+        return false;
+    }
+    bool ok = parse(data, file.size(), header);
+    if (ok && header.format == ImageHeader::Png && png) {
+        // Сводка по чанкам и метаданные PNG - за один проход по тому же отображению
+        if (metadata) {
+            *metadata = ImageMetadata();
+        }
+        walkPng(data, file.size(), *png, metadata);
+    } else if (ok && metadata) {
+        parseMetadata(data, file.size(), *metadata);
+    }
+    if (ok && animation && header.frameCount > 1) {
+        // Холст есть только у GIF; страницы TIFF бывают разного размера законно
+        QVector<FrameInfo> list;
+        int loopCount;
+        if (frames(data, file.size(), list, &loopCount)) {
+            bool gif = header.format == ImageHeader::Gif;
+            *animation = summarize(list, gif ? header.width : 0, gif ? header.height : 0, loopCount);
+        }
+    }
+    file.unmap(data);
+    return ok;
+}
@@ -0,0 +1,200 @@
+#ifndef IMAGEHEADER_H
+#define IMAGEHEADER_H
+
+#include <QString>
+#include <QVector>
+#include <QDateTime>
+
+// Сведения, которые можно достать из заголовка файла без декодирования пикселей.
+// Только простые поля, чтобы разбор не выделял память.
+struct ImageHeader
+{
+    enum Format { Unknown, Bmp, Png, Gif, Jpeg, Tiff, Pcx };
+    enum Compression {
+        NoCompression, RleCompression, LzwCompression, DeflateCompression,
+        JpegCompression, PackBitsCompression, CcittCompression, OtherCompression
+    };
+
+    Format format = Unknown;
+    Compression compression = NoCompression;
+    int compressionCode = 0;   // значение из файла: biCompression, тег TIFF, маркер SOF
+    bool interlaced = false;   // Adam7 в PNG, чересстрочный первый кадр GIF
+    bool progressive = false;  // прогрессивный JPEG
+    bool lossless = false;     // JPEG без потерь (SOF3, SOF7, SOF11, SOF15)
+    int lzwCodeSize = 0;       // минимальный размер кода LZW первого кадра GIF
+    int quality = 0;           // JPEG: качество IJG 1-100 по таблицам квантования, 0 - не оценено
+    bool qualityExact = false; // таблицы в точности те, что строит libjpeg для этого качества
+    int chromaSubsampling = 0; // JPEG: прореживание цветности, (по горизонтали << 4) | по вертикали; 0 - нет цветности
+    bool optimizedHuffman = false; // JPEG: таблицы Хаффмана не из приложения K стандарта
+    int width = 0;
+    int height = 0;
+    int depth = 0;         // бит на пиксель в самом файле
+    int dpi = 0;           // 0, если в файле не указано
+    int paletteSize = 0;
+    int frameCount = 1;    // кадры GIF или страницы TIFF
+    bool hasAlpha = false;
+    bool grayscale = false;
+};
+
+// Где в файле лежат несжатые строки пикселей (TIFF без сжатия, BMP BI_RGB):
+// по ней отдельные строки читаются прямо из файла без декодирования всего изображения
+struct RasterLayout
+{
+    enum Order { Gray, Indexed, Rgb, Bgr };
+
+    Order order = Gray;
+    int bytesPerPixel = 1;
+    bool alpha = false;        // четвёртый байт пикселя - прозрачность
+    bool inverted = false;     // TIFF WhiteIsZero: 0 - белый, значения серого инвертируются
+    int width = 0;
+    int height = 0;
+    qint64 stride = 0;         // байт на строку
+    qint64 firstRow = 0;       // смещение первой полосы
+    bool bottomUp = false;     // BMP: строки хранятся снизу вверх
+
+    // TIFF с несколькими полосами: смещения полос - массив в файле
+    qint64 stripOffsets = -1;
+    int stripOffsetSize = 4;
+    int stripCount = 1;
+    int rowsPerStrip = 0;
+    bool bigEndian = false;
+
+    // BMP с палитрой: записи BGRx
+    qint64 palette = -1;
+    int paletteSize = 0;
+    int paletteStride = 4;
+
+    // Смещение строки y или -1, если строка выходит за пределы файла
+    qint64 rowOffset(const uchar *data, qint64 size, int y) const;
+};
+
+// Один кадр GIF или страница TIFF, как они описаны в файле. Собирается
+// проходом по блокам: данные LZW и полосы TIFF пропускаются по длинам
+struct FrameInfo
+{
+    int left = 0;
+    int top = 0;
+    int width = 0;
+    int height = 0;
+    int delay = 0;             // мс; в GIF записана в сотых долях секунды
+    int disposal = 0;          // GIF: что делать с кадром перед следующим
+    int paletteSize = 0;       // собственная палитра кадра, 0 - общая
+    int depth = 0;             // TIFF: бит на пиксель страницы
+    int compressionCode = 0;   // TIFF: тег Compression
+    bool transparent = false;
+    bool interlaced = false;
+    bool reduced = false;      // TIFF: уменьшенная копия другой страницы (NewSubfileType)
+    qint64 dataSize = 0;       // байт сжатых данных
+};
+
+// Сводка по кадрам для таблицы и кэша
+struct FrameSummary
+{
+    int frames = 0;
+    qint64 duration = 0;       // мс, сумма задержек кадров
+    int minDelay = 0;
+    int maxDelay = 0;
+    int loopCount = -1;        // GIF NETSCAPE2.0: 0 - бесконечно, -1 - блока нет (один проход)
+    int localPalettes = 0;     // кадров со своей палитрой
+    int partialFrames = 0;     // кадров меньше холста
+    int reducedPages = 0;      // страниц TIFF - уменьшенных копий
+    qint64 dataSize = 0;       // байт сжатых данных всех кадров
+
+    bool isNull() const { return frames == 0; }
+};
+
+// Метаданные EXIF, XMP и ICC. Разбираются прямо по отображённому в память
+// файлу: сегменты APP1/APP2 JPEG, чанки eXIf, iTXt и iCCP PNG, теги TIFF.
+// Копируются только итоговые строки
+struct ImageMetadata
+{
+    int orientation = 0;       // EXIF Orientation 1-8, 0 - не указана
+    QString make;
+    QString model;
+    QDateTime captureTime;     // DateTimeOriginal, иначе DateTime; без часового пояса
+    int dpi = 0;               // XResolution и ResolutionUnit
+
+    // Встроенная JPEG-миниатюра EXIF: смещение от начала файла и длина
+    qint64 thumbnailOffset = 0;
+    qint64 thumbnailSize = 0;
+    int thumbnailWidth = 0;
+    int thumbnailHeight = 0;
+
+    qint64 exifSize = 0;       // байт в файле, 0 - блока нет
+    qint64 xmpSize = 0;
+    qint64 iccSize = 0;        // в PNG - сжатый размер iCCP
+    QString iccColorSpace;     // "RGB", "GRAY", "CMYK"; в PNG неизвестно без распаковки
+    QString iccDescription;    // описание профиля, в PNG - имя из iCCP
+
+    bool isNull() const
+    {
+        return exifSize == 0 && xmpSize == 0 && iccSize == 0 && orientation == 0 && make.isEmpty() && model.isEmpty();
+    }
+
+    // Производитель и модель, без повтора производителя в модели
+    QString camera() const;
+};
+
+// Сведения PNG по всем чанкам: проход по длинам до IEND, IDAT не распаковывается
+struct PngInfo
+{
+    enum Chunk {
+        Gamma        = 0x001,   // gAMA
+        IccProfile   = 0x002,   // iCCP
+        PhysicalSize = 0x004,   // pHYs
+        Srgb         = 0x008,   // sRGB
+        Chromaticity = 0x010,   // cHRM
+        Background   = 0x020,   // bKGD
+        Transparency = 0x040,   // tRNS
+        Text         = 0x080,   // tEXt, zTXt, iTXt
+        Time         = 0x100,   // tIME
+        Exif         = 0x200    // eXIf
+    };
+
+    int bitDepth = 0;
+    int colorType = 0;         // 0 - серый, 2 - RGB, 3 - палитра, 4 - серый с альфой, 6 - RGBA
+    bool interlaced = false;
+    int chunks = 0;            // найденные вспомогательные чанки, набор Chunk
+    int chunkCount = 0;
+    int idatCount = 0;
+    qint64 idatSize = 0;       // байт сжатых данных
+    qint64 rawSize = 0;        // байт после распаковки: строки с байтом фильтра, для Adam7 - по проходам
+    int gamma = 0;             // gAMA, гамма x 100000
+    qint64 metadataSize = 0;   // чанки, не влияющие на вид: текст, время, неизвестные вспомогательные
+    qint64 trailingSize = 0;   // байт после IEND
+
+    bool isNull() const { return bitDepth == 0; }
+    double compressionRatio() const { return idatSize > 0 ? double(rawSize) / idatSize : 0; }
+    qint64 wastedSize() const { return metadataSize + trailingSize; }
+};
+
+namespace ImageHeaders
+{
+    // Формат определяется по сигнатуре, а не по расширению
+    // Метаданные, чанки PNG и кадры разбираются по тому же отображению файла, если заданы
+    bool read(const QString &filePath, ImageHeader &header, ImageMetadata *metadata = nullptr, PngInfo *png = nullptr,
+              FrameSummary *animation = nullptr);
+    bool parse(const uchar *data, qint64 size, ImageHeader &header);
+
+    // Имя формата в том же виде, что и расширение файла в верхнем регистре
+    const char *formatName(ImageHeader::Format format);
+    // Короткое имя метода сжатия для машинного вывода: "none", "lzw", "jpeg"...
+    const char *compressionName(ImageHeader::Compression compression);
+    // "4:2:0", "4:4:4"...; пустая строка для нет цветности и редких сочетаний
+    const char *subsamplingName(int chromaSubsampling);
+
+    // false для сжатых, плиточных и не 8-битных растров
+    bool rasterLayout(const uchar *data, qint64 size, RasterLayout &layout);
+
+    // false, если в файле нет ни EXIF, ни XMP, ни ICC
+    bool parseMetadata(const uchar *data, qint64 size, ImageMetadata &metadata);
+
+    // Один последовательный проход по заголовкам чанков; false, если это не PNG
+    bool pngChunks(const uchar *data, qint64 size, PngInfo &png);
+
+    // Кадры GIF и страницы TIFF без распаковки; false для остальных форматов
+    bool frames(const uchar *data, qint64 size, QVector<FrameInfo> &frameList, int *loopCount = nullptr);
+    FrameSummary summarize(const QVector<FrameInfo> &frameList, int canvasWidth, int canvasHeight, int loopCount);
+}
+
+#endif // IMAGEHEADER_H
@@ -1,8 +1,19 @@
 #include <QApplication>
+#include <QCoreApplication>
 #include "imageanalyzer.h"
+#include "analyzercli.h"
 
 int main(int argc, char *argv[])
 {
+    // С --cli окно не создаётся, поэтому дисплей не нужен
+    if (AnalyzerCli::isRequested(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        app.setApplicationName("Image Analyzer");
+
+        AnalyzerCli cli;
+        return cli.run(app.arguments());
+    }
+
     QApplication app(argc, argv);
     app.setApplicationName("Image Analyzer");
 
@@ -0,0 +1,137 @@
+#include "pathstore.h"
+
+namespace {
+
+// Путь делится на папку и имя по последнему '/', пути из Qt всегда с '/'
+void splitPath(const QString &filePath, QStringView &directory, QStringView &name)
+{
+    qsizetype slash = filePath.lastIndexOf(QLatin1Char('/'));
+    directory = QStringView(filePath).left(slash + 1);
+    name = QStringView(filePath).mid(slash + 1);
+}
+
+}
+
+PathStore::PathStore()
+{
+    clear();
+}
+
+size_t PathStore::hashOf(qint32 directory, QStringView name)
+{
+    return qHash(name) ^ (size_t(directory) * 0x9E3779B97F4A7C15ull);
+}
+
+qsizetype PathStore::findBucket(qint32 directory, QStringView name, size_t hash) const
+{
+    qsizetype mask = buckets.size() - 1;
+    qsizetype bucket = qsizetype(hash) & mask;
+    forever {
+        qint32 entry = buckets[bucket];
+        if (entry < 0 || (directoryOf[entry] == directory && fileName(entry) == name)) {
+            return bucket;
+        }
+        bucket = (bucket + 1) & mask;
+    }
+}
+
+void PathStore::rehash(qsizetype bucketCount)
+{
+    buckets = QVector<qint32>(bucketCount, -1);
+    for (int i = 0; i < count(); ++i) {
+        buckets[findBucket(directoryOf[i], fileName(i), hashOf(directoryOf[i], fileName(i)))] = i;
+    }
+}
+
+qint32 PathStore::directoryId(QStringView directory)
+{
+    if (lastDirectory >= 0 && directories[lastDirectory] == directory) {
+        return lastDirectory;
+    }
+
+    QString key = directory.toString();
+    auto it = directoryIds.constFind(key);
+    if (it != directoryIds.constEnd()) {
+        lastDirectory = it.value();
+    } else {
+        lastDirectory = qint32(directories.count());
+        directories.append(key);
+        directoryIds.insert(key, lastDirectory);
+    }
+    return lastDirectory;
+}
+
+bool PathStore::add(const QString &filePath)
+{
+    QStringView directoryPath, name;
+    splitPath(filePath, directoryPath, name);
+
+    // Имена длиннее 65535 символов в файловых системах не встречаются
+    if (name.size() > 0xFFFF) {
+        return false;
+    }
+
+    qint32 directory = directoryId(directoryPath);
+    size_t hash = hashOf(directory, name);
+    qsizetype bucket = findBucket(directory, name, hash);
+    if (buckets[bucket] >= 0) {
+        return false;
+    }
+
+    qint32 entry = qint32(nameOffsets.count());
+    nameOffsets.append(qint32(arena.size()));
+    nameLengths.append(quint16(name.size()));
+    directoryOf.append(directory);
+    arena.append(name);
+    buckets[bucket] = entry;
+
+    // Заполнение не больше половины, чтобы цепочки проб оставались короткими
+    if (qsizetype(count()) * 2 > buckets.size()) {
+        rehash(buckets.size() * 2);
+    }
+    return true;
+}
+
+bool PathStore::contains(const QString &filePath) const
+{
+    return indexOf(filePath) >= 0;
+}
+
+int PathStore::indexOf(const QString &filePath) const
+{
+    QStringView directory, name;
+    splitPath(filePath, directory, name);
+
+    auto it = directoryIds.constFind(directory.toString());
+    if (it == directoryIds.constEnd()) {
+        return -1;
+    }
+    return buckets[findBucket(it.value(), name, hashOf(it.value(), name))];
+}
+
+int PathStore::count() const
+{
+    return int(nameOffsets.count());
+}
+
+QString PathStore::path(int i) const
+{
+    return directories[directoryOf[i]] + fileName(i);
+}
+
+QStringView PathStore::fileName(int i) const
+{
+    return QStringView(arena).mid(nameOffsets[i], nameLengths[i]);
+}
+
+void PathStore::clear()
+{
+    directories.clear();
+    directoryIds.clear();
+    arena.clear();
+    nameOffsets.clear();
+    nameLengths.clear();
+    directoryOf.clear();
+    lastDirectory = -1;
+    buckets = QVector<qint32>(64, -1);
+}
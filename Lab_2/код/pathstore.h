@@ -0,0 +1,48 @@
+#ifndef PATHSTORE_H
+#define PATHSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+
+// Компактный набор путей без повторов. Папки хранятся один раз и
+// ссылаются по номеру, имена файлов лежат подряд в одной строке-арене,
+// а проверка на повтор - открытая адресация по индексам, то есть O(1)
+// без отдельной копии пути в хэш-таблице.
+class PathStore
+{
+private:
+    QStringList directories;
+    QHash<QString, qint32> directoryIds;
+    qint32 lastDirectory;      // файлы обычно идут подряд из одной папки
+
+    QString arena;
+    QVector<qint32> nameOffsets;
+    QVector<quint16> nameLengths;
+    QVector<qint32> directoryOf;
+
+    QVector<qint32> buckets;   // номер записи или -1
+
+    static size_t hashOf(qint32 directory, QStringView name);
+    qsizetype findBucket(qint32 directory, QStringView name, size_t hash) const;
+    void rehash(qsizetype bucketCount);
+    qint32 directoryId(QStringView directory);
+
+public:
+    PathStore();
+
+    // true, если путь новый; номер нового пути - count() - 1
+    bool add(const QString &filePath);
+    bool contains(const QString &filePath) const;
+    // Номер пути или -1
+    int indexOf(const QString &filePath) const;
+
+    int count() const;
+    QString path(int i) const;
+    QStringView fileName(int i) const;
+
+    void clear();
+};
+
+#endif // PATHSTORE_H
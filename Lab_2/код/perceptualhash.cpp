@@ -0,0 +1,139 @@
+#include "perceptualhash.h"
+#include <QImageReader>
+#include <QImage>
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+
+using PerceptualHash::SampleSize;
+
+// Из DCT нужны только 8x8 низких частот
+const int Frequencies = 8;
+
+const double *cosines(int frequency)
+{
+    static const struct Table {
+        double values[Frequencies][SampleSize];
+        Table()
+        {
+            for (int u = 0; u < Frequencies; ++u) {
+                for (int x = 0; x < SampleSize; ++x) {
+                    values[u][x] = std::cos((2 * x + 1) * u * M_PI / (2 * SampleSize));
+                }
+            }
+        }
+    } table;
+    return table.values[frequency];
+}
+
+quint64 differenceHash(const double pixels[SampleSize][SampleSize])
+{
+    // Уменьшение до 9x8 средним по клеткам, затем знак разности соседей в строке
+    double cells[8][9];
+    for (int cy = 0; cy < 8; ++cy) {
+        int top = cy * SampleSize / 8;
+        int bottom = (cy + 1) * SampleSize / 8;
+        for (int cx = 0; cx < 9; ++cx) {
+            int left = cx * SampleSize / 9;
+            int right = (cx + 1) * SampleSize / 9;
+            double sum = 0;
+            for (int y = top; y < bottom; ++y) {
+                for (int x = left; x < right; ++x) {
+                    sum += pixels[y][x];
+                }
+            }
+            cells[cy][cx] = sum / ((bottom - top) * (right - left));
+        }
+    }
+
+    quint64 hash = 0;
+    for (int cy = 0; cy < 8; ++cy) {
+        for (int cx = 0; cx < 8; ++cx) {
+            if (cells[cy][cx] < cells[cy][cx + 1]) {
+                hash |= quint64(1) << (cy * 8 + cx);
+            }
+        }
+    }
+    return hash;
+}
+
+quint64 dctHash(const double pixels[SampleSize][SampleSize])
+{
+    // Разделимое DCT-II: сначала по строкам, потом по столбцам, только нужные частоты
+    double rows[SampleSize][Frequencies];
+    for (int y = 0; y < SampleSize; ++y) {
+        for (int u = 0; u < Frequencies; ++u) {
+            const double *c = cosines(u);
+            double sum = 0;
+            for (int x = 0; x < SampleSize; ++x) {
+                sum += pixels[y][x] * c[x];
+            }
+            rows[y][u] = sum;
+        }
+    }
+
+    double coefficients[Frequencies * Frequencies];
+    for (int v = 0; v < Frequencies; ++v) {
+        const double *c = cosines(v);
+        for (int u = 0; u < Frequencies; ++u) {
+            double sum = 0;
+            for (int y = 0; y < SampleSize; ++y) {
+                sum += rows[y][u] * c[y];
+            }
+            coefficients[v * Frequencies + u] = sum;
+        }
+    }
+
+    // Постоянная составляющая (средняя яркость) в медиану не входит
+    double ac[Frequencies * Frequencies - 1];
+    std::copy(coefficients + 1, coefficients + Frequencies * Frequencies, ac);
+    std::nth_element(ac, ac + 31, ac + 63);
+    double median = ac[31];
+
+    quint64 hash = 0;
+    for (int i = 1; i < Frequencies * Frequencies; ++i) {
+        if (coefficients[i] > median) {
+            hash |= quint64(1) << i;
+        }
+    }
+    return hash;
+}
+
+}
+
+bool PerceptualHash::compute(const QString &filePath, quint64 &dHash, quint64 &pHash)
+{
+    QImageReader reader(filePath);
+    if (!reader.canRead()) {
+        return false;
+    }
+
+    // Пропорции не сохраняются: хэши сравнивают изображения целиком
+    reader.setScaledSize(QSize(SampleSize, SampleSize));
+    QImage image;
+    if (!reader.read(&image)) {
+        return false;
+    }
+    fromImage(image, dHash, pHash);
+    return true;
+}
+
+void PerceptualHash::fromImage(const QImage &image, quint64 &dHash, quint64 &pHash)
+{
+    QImage gray = image;
+    if (gray.width() != SampleSize || gray.height() != SampleSize) {
+        gray = gray.scaled(SampleSize, SampleSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+    gray = gray.convertToFormat(QImage::Format_Grayscale8);
+
+    double pixels[SampleSize][SampleSize];
+    for (int y = 0; y < SampleSize; ++y) {
+        const uchar *line = gray.constScanLine(y);
+        for (int x = 0; x < SampleSize; ++x) {
+            pixels[y][x] = line[x];
+        }
+    }
+    dHash = differenceHash(pixels);
+    pHash = dctHash(pixels);
+}
@@ -0,0 +1,30 @@
+#ifndef PERCEPTUALHASH_H
+#define PERCEPTUALHASH_H
+
+#include <QString>
+#include <QtGlobal>
+#include <QtAlgorithms>
+
+class QImage;
+
+// Перцептивные хэши для поиска похожих изображений. Изображение
+// декодируется сразу в 32x32 (QImageReader::setScaledSize, для JPEG это
+// масштабирование DCT) и переводится в градации серого.
+// dHash - знаки разностей соседних пикселей уменьшенного до 9x8 изображения;
+// pHash - знаки 64 низких частот DCT 32x32 относительно их медианы.
+// Похожие изображения отличаются в немногих битах, поэтому мера
+// близости - расстояние Хэмминга.
+namespace PerceptualHash
+{
+    const int SampleSize = 32;
+
+    // false, если Qt не умеет читать файл (например, PCX)
+    bool compute(const QString &filePath, quint64 &dHash, quint64 &pHash);
+
+    // Уже декодированное изображение любого размера, уменьшается до SampleSize
+    void fromImage(const QImage &image, quint64 &dHash, quint64 &pHash);
+
+    inline int distance(quint64 a, quint64 b) { return qPopulationCount(a ^ b); }
+}
+
+#endif // PERCEPTUALHASH_H
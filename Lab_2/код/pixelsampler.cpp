@@ -0,0 +1,135 @@
+#include "pixelsampler.h"
+#include "pixelstats.h"
+#include "colorsummary.h"
+#include <QFile>
+#include <QRandomGenerator>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+bool sampleRaster(const uchar *data, qint64 size, const RasterLayout &layout, int budget, ImageInfo &info)
+{
+    QRgb palette[256] = {};
+    if (layout.order == RasterLayout::Indexed) {
+        if (layout.palette + qint64(layout.paletteSize) * layout.paletteStride > size) {
+            return false;
+        }
+        for (int i = 0; i < layout.paletteSize; ++i) {
+            const uchar *entry = data + layout.palette + i * layout.paletteStride;
+            palette[i] = qRgb(entry[2], entry[1], entry[0]);
+        }
+    }
+
+    // Клетки сетки примерно квадратные в пикселях изображения
+    int rows = qBound(1, int(std::lround(std::sqrt(double(budget) * layout.height / layout.width))), layout.height);
+    int columns = qBound(1, budget / rows, layout.width);
+
+    // Выборка зависит только от файла, поэтому повторный анализ даёт тот же результат
+    QRandomGenerator random(quint32(size) ^ quint32(layout.width) * 2654435761u ^ quint32(layout.height));
+
+    QVector<QRgb> samples;
+    samples.reserve(qsizetype(rows) * columns);
+    for (int row = 0; row < rows; ++row) {
+        int top = int(qint64(row) * layout.height / rows);
+        int bottom = int(qint64(row + 1) * layout.height / rows);
+        qint64 offset = layout.rowOffset(data, size, top + int(random.bounded(quint32(qMax(bottom - top, 1)))));
+        if (offset < 0) {
+            return false;
+        }
+        const uchar *line = data + offset;
+
+        for (int column = 0; column < columns; ++column) {
+            int left = int(qint64(column) * layout.width / columns);
+            int right = int(qint64(column + 1) * layout.width / columns);
+            int x = left + int(random.bounded(quint32(qMax(right - left, 1))));
+            const uchar *p = line + qint64(x) * layout.bytesPerPixel;
+
+            QRgb color;
+            switch (layout.order) {
+            case RasterLayout::Gray: {
+                int gray = layout.inverted ? 255 - p[0] : p[0];
+                color = qRgb(gray, gray, gray);
+                break;
+            }
+            case RasterLayout::Indexed: color = palette[p[0]]; break;
+            case RasterLayout::Rgb:     color = qRgba(p[0], p[1], p[2], layout.alpha ? p[3] : 255); break;
+            default:                    color = qRgb(p[2], p[1], p[0]); break;
+            }
+            samples.append(color);
+        }
+    }
+
+    qsizetype n = samples.size();
+    PixelStats stats = PixelStats::computeArgb(samples.constData(), int(n), 1, n, layout.alpha, PixelStats::All);
+    info.colors = ColorSummary::computeArgb(samples.constData(), int(n), 1, n, layout.alpha);
+
+    // Chao1: число цветов, которых нет в выборке, оценивается по числу
+    // цветов, встреченных ровно один (f1) и ровно два (f2) раза
+    for (QRgb &color : samples) {
+        color &= 0xFFFFFF;
+    }
+    std::sort(samples.begin(), samples.end());
+    double f1 = 0;
+    double f2 = 0;
+    for (qsizetype i = 0; i < n;) {
+        qsizetype j = i;
+        while (j < n && samples[j] == samples[i]) {
+            ++j;
+        }
+        f1 += j - i == 1;
+        f2 += j - i == 2;
+        i = j;
+    }
+    double unseen = f1 * (f1 - 1) / (2 * (f2 + 1));
+    double variance = unseen
+                      + f1 * (2 * f1 - 1) * (2 * f1 - 1) / (4 * (f2 + 1) * (f2 + 1))
+                      + f1 * f1 * f2 * (f1 - 1) * (f1 - 1) / (4 * std::pow(f2 + 1, 4));
+
+    double maxColors = qMin(double(qint64(layout.width) * layout.height), double(1 << 24));
+    if (layout.order == RasterLayout::Gray) {
+        maxColors = 256;
+    } else if (layout.order == RasterLayout::Indexed) {
+        maxColors = layout.paletteSize;
+    }
+
+    info.grayscale = stats.grayscale;
+    info.hasAlpha = stats.alphaUsed;
+    info.uniqueColors = int(qMin(stats.uniqueColors + unseen, maxColors));
+    info.uniqueColorsError = int(qMin(std::ceil(1.96 * std::sqrt(variance)), maxColors));
+    info.effectiveBits = stats.colorBits();
+    info.sampledPixels = n;
+    info.pixelStats = true;
+    return true;
+}
+
+}
+
+bool PixelSampler::estimate(const QString &filePath, int budget, ImageInfo &info)
+{
+    QFile file(filePath);
+    if (budget <= 0 || !file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // Отображение ленивое: с диска читаются только страницы выбранных строк
+    qint64 size = file.size();
+    uchar *data = size > 0 ? file.map(0, size) : nullptr;
+    if (!data) {
+        return false;
+    }
+
+    RasterLayout layout;
+    bool ok = ImageHeaders::rasterLayout(data, size, layout) && sampleRaster(data, size, layout, budget, info);
+    if (ok) {
+        info.sampleBudget = budget;
+    }
+    file.unmap(data);
+    return ok;
+}
+
+double PixelSampler::missedFraction(qint64 samples)
+{
+    return samples > 0 ? qMin(1.0, -std::log(1 - Confidence) / samples) : 1.0;
+}
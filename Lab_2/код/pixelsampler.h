@@ -0,0 +1,31 @@
+#ifndef PIXELSAMPLER_H
+#define PIXELSAMPLER_H
+
+#include <QString>
+#include "imageanalysis.h"
+
+// Статистика по пикселям для очень больших изображений по выборке.
+// Строки читаются прямо из файла там, где их расположение известно
+// без декодирования (TIFF без сжатия, BMP BI_RGB): изображение делится
+// на полосы и столбцы, и из каждой клетки берётся один случайный пиксель.
+//
+// Серость и прозрачность по выборке: найденный цветной или прозрачный
+// пиксель даёт точный ответ, а если их нет, доля таких пикселей с
+// вероятностью 95% меньше 3/n (правило трёх). Число цветов оценивается
+// по Chao1 с 95% интервалом; при очень многих редких цветах это скорее
+// оценка снизу.
+namespace PixelSampler
+{
+    const double Confidence = 0.95;
+
+    // Выборка применяется, если пикселей больше budget * MinOversampling
+    const int MinOversampling = 4;
+
+    // false, если для файла нельзя читать строки напрямую
+    bool estimate(const QString &filePath, int budget, ImageInfo &info);
+
+    // Верхняя граница доли пикселей, не встретившихся в выборке из n
+    double missedFraction(qint64 samples);
+}
+
+#endif // PIXELSAMPLER_H
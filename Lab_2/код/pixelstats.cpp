@@ -0,0 +1,226 @@
+#include "pixelstats.h"
+#include <QImage>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PIXELSTATS_SSE2
+#endif
+
+namespace {
+
+const int BitmapWords = (1 << 24) / 64;
+
+// Битовая карта цветов - 2 МБ, поэтому одна на поток и переиспользуется
+std::vector<quint64> &colorBitmap()
+{
+    thread_local std::vector<quint64> bitmap(BitmapWords, 0);
+    return bitmap;
+}
+
+int bitsForLevels(int levels)
+{
+    int bits = 0;
+    while ((1 << bits) < levels) {
+        ++bits;
+    }
+    return bits;
+}
+
+}
+
+void PixelStats::finishHistograms()
+{
+    for (int channel = 0; channel < ChannelCount; ++channel) {
+        int levels = 0;
+        for (quint32 count : histograms[channel]) {
+            levels += count != 0;
+        }
+        effectiveBits[channel] = bitsForLevels(levels);
+    }
+}
+
+int PixelStats::colorBits() const
+{
+    return qMax(effectiveBits[Red], qMax(effectiveBits[Green], effectiveBits[Blue]));
+}
+
+PixelStats PixelStats::computeArgb(const QRgb *pixels, int width, int height, qsizetype stride,
+                                   bool hasAlpha, int requests)
+{
+    PixelStats stats;
+    bool wantUnique = requests & UniqueColors;
+    bool wantHistograms = requests & Histograms;
+    bool perPixel = wantUnique || wantHistograms;
+    bool checkAlpha = hasAlpha && (requests & Alpha);
+
+    // Отличия R от G и G от B копятся в битах 8-23, прозрачность - как AND альфа-байтов
+    quint32 grayDiff = 0;
+    quint32 alphaAnd = 0xFFFFFFFFu;
+
+    std::vector<quint64> *bitmap = wantUnique ? &colorBitmap() : nullptr;
+    quint64 *words = bitmap ? bitmap->data() : nullptr;
+    int unique = 0;
+
+    int y = 0;
+    for (; y < height; ++y) {
+        const QRgb *line = pixels + qsizetype(y) * stride;
+        int x = 0;
+
+#ifdef PIXELSTATS_SSE2
+        __m128i diff = _mm_setzero_si128();
+        __m128i alpha = _mm_set1_epi32(-1);
+        for (; x + 4 <= width; x += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(line + x));
+            diff = _mm_or_si128(diff, _mm_xor_si128(v, _mm_slli_epi32(v, 8)));
+            alpha = _mm_and_si128(alpha, v);
+        }
+        alignas(16) quint32 lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), diff);
+        grayDiff |= lanes[0] | lanes[1] | lanes[2] | lanes[3];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), alpha);
+        alphaAnd &= lanes[0] & lanes[1] & lanes[2] & lanes[3];
+#endif
+        for (; x < width; ++x) {
+            QRgb p = line[x];
+            grayDiff |= p ^ (p << 8);
+            alphaAnd &= p;
+        }
+
+        // Строка только что прочитана и лежит в кэше процессора
+        if (perPixel) {
+            for (x = 0; x < width; ++x) {
+                QRgb p = line[x];
+                if (wantHistograms) {
+                    ++stats.histograms[Red][qRed(p)];
+                    ++stats.histograms[Green][qGreen(p)];
+                    ++stats.histograms[Blue][qBlue(p)];
+                    if (hasAlpha) {
+                        ++stats.histograms[AlphaChannel][qAlpha(p)];
+                    }
+                }
+                if (wantUnique) {
+                    quint32 rgb = p & 0xFFFFFF;
+                    quint64 &word = words[rgb >> 6];
+                    quint64 bit = quint64(1) << (rgb & 63);
+                    unique += (word & bit) == 0;
+                    word |= bit;
+                }
+            }
+        } else {
+            bool grayKnown = !(requests & Grayscale) || (grayDiff & 0x00FFFF00);
+            bool alphaKnown = !checkAlpha || (alphaAnd >> 24) != 0xFF;
+            if (grayKnown && alphaKnown) {
+                ++y;
+                break;
+            }
+        }
+    }
+
+    stats.complete = y >= height;
+    stats.grayscale = (grayDiff & 0x00FFFF00) == 0;
+    stats.alphaUsed = hasAlpha && (alphaAnd >> 24) != 0xFF;
+
+    if (wantUnique) {
+        stats.uniqueColors = unique;
+
+        // Для небольших изображений быстрее стереть только задетые слова
+        if (qint64(width) * height < BitmapWords) {
+            for (int row = 0; row < height; ++row) {
+                const QRgb *line = pixels + qsizetype(row) * stride;
+                for (int x = 0; x < width; ++x) {
+                    words[(line[x] & 0xFFFFFF) >> 6] = 0;
+                }
+            }
+        } else {
+            std::memset(words, 0, BitmapWords * sizeof(quint64));
+        }
+    }
+    if (wantHistograms) {
+        if (!hasAlpha) {
+            stats.histograms[AlphaChannel][255] = quint32(qint64(width) * height);
+        }
+        stats.finishHistograms();
+    }
+    return stats;
+}
+
+PixelStats PixelStats::computeIndexed(const uchar *indices, int width, int height, qsizetype stride,
+                                      const QRgb *palette, int paletteSize, int requests)
+{
+    // Один проход считает индексы, всё остальное выводится из палитры
+    quint32 counts[256] = {};
+    for (int y = 0; y < height; ++y) {
+        const uchar *line = indices + qsizetype(y) * stride;
+        for (int x = 0; x < width; ++x) {
+            ++counts[line[x]];
+        }
+    }
+
+    PixelStats stats;
+    QRgb used[256];
+    int usedCount = 0;
+    for (int i = 0; i < 256; ++i) {
+        if (counts[i] == 0) {
+            continue;
+        }
+        QRgb color = i < paletteSize ? palette[i] : qRgb(0, 0, 0);
+        stats.grayscale &= qRed(color) == qGreen(color) && qGreen(color) == qBlue(color);
+        stats.alphaUsed |= qAlpha(color) != 255;
+        stats.histograms[Red][qRed(color)] += counts[i];
+        stats.histograms[Green][qGreen(color)] += counts[i];
+        stats.histograms[Blue][qBlue(color)] += counts[i];
+        stats.histograms[AlphaChannel][qAlpha(color)] += counts[i];
+        used[usedCount++] = color & 0xFFFFFF;
+    }
+
+    if (requests & UniqueColors) {
+        // В палитре бывают одинаковые цвета под разными индексами
+        std::sort(used, used + usedCount);
+        stats.uniqueColors = int(std::unique(used, used + usedCount) - used);
+    }
+    if (requests & Histograms) {
+        stats.finishHistograms();
+    } else {
+        std::memset(stats.histograms, 0, sizeof(stats.histograms));
+    }
+    return stats;
+}
+
+PixelStats PixelStats::compute(const QImage &image, int requests)
+{
+    switch (image.format()) {
+    case QImage::Format_Indexed8: {
+        QList<QRgb> palette = image.colorTable();
+        return computeIndexed(image.constBits(), image.width(), image.height(), image.bytesPerLine(),
+                              palette.constData(), int(palette.size()), requests);
+    }
+    case QImage::Format_Grayscale8: {
+        static const QList<QRgb> ramp = [] {
+            QList<QRgb> colors(256);
+            for (int i = 0; i < 256; ++i) {
+                colors[i] = qRgb(i, i, i);
+            }
+            return colors;
+        }();
+        return computeIndexed(image.constBits(), image.width(), image.height(), image.bytesPerLine(),
+                              ramp.constData(), 256, requests);
+    }
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+        return computeArgb(reinterpret_cast<const QRgb *>(image.constBits()), image.width(), image.height(),
+                           image.bytesPerLine() / 4, image.format() == QImage::Format_ARGB32, requests);
+    default:
+        break;
+    }
+
+    // Остальные форматы приводятся к 8 битам на канал: 16-битные теряют
+    // младшие разряды, и эффективная разрядность считается не больше 8
+    if (image.depth() < 8) {
+        return compute(image.convertToFormat(QImage::Format_Indexed8), requests);
+    }
+    return compute(image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32),
+                   requests);
+}
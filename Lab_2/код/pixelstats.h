@@ -0,0 +1,51 @@
+#ifndef PIXELSTATS_H
+#define PIXELSTATS_H
+
+#include <QtGlobal>
+#include <QRgb>
+
+class QImage;
+
+// Статистика по пикселям за один проход по изображению: настоящая
+// серость (R == G == B у всех пикселей), реально используемая
+// прозрачность (а не только флаг формата), число различных цветов по
+// битовой карте на 2^24 бит, гистограммы каналов и эффективная разрядность.
+// Проверки серости и прозрачности идут по 4 пикселя на SSE2; если нужны
+// только они, проход заканчивается, как только оба ответа известны.
+struct PixelStats
+{
+    enum Request {
+        Grayscale    = 0x01,
+        Alpha        = 0x02,
+        UniqueColors = 0x04,
+        Histograms   = 0x08,   // вместе с эффективной разрядностью
+        All          = 0x0F
+    };
+
+    enum Channel { Red, Green, Blue, AlphaChannel, ChannelCount };
+
+    bool grayscale = true;
+    bool alphaUsed = false;
+    int uniqueColors = 0;                       // различных RGB без учёта прозрачности
+    quint32 histograms[ChannelCount][256] = {};
+    int effectiveBits[ChannelCount] = {};       // log2 числа используемых уровней, с округлением вверх
+    bool complete = true;                       // false, если проход закончился досрочно
+
+    static PixelStats compute(const QImage &image, int requests = All);
+
+    // Пиксели 0xAARRGGBB, stride - в пикселях; без hasAlpha старший байт не читается
+    static PixelStats computeArgb(const QRgb *pixels, int width, int height, qsizetype stride,
+                                  bool hasAlpha, int requests = All);
+
+    // Индексы палитры по байту на пиксель, stride - в байтах
+    static PixelStats computeIndexed(const uchar *indices, int width, int height, qsizetype stride,
+                                     const QRgb *palette, int paletteSize, int requests = All);
+
+    // Наибольшая эффективная разрядность среди каналов цвета
+    int colorBits() const;
+
+private:
+    void finishHistograms();
+};
+
+#endif // PIXELSTATS_H
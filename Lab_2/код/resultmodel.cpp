@@ -0,0 +1,883 @@
+#include "resultmodel.h"
+#include "thumbnailservice.h"
+#include "analysisprofiler.h"
+#include "pixelsampler.h"
+#include <QColor>
+#include <QPixmap>
+#include <QPainter>
+
+namespace {
+
+// Секторы тона по 30°, начиная с 0°
+const char *const HueNames[ColorSummary::HueBins] = {
+    "красный", "оранжевый", "жёлтый", "жёлто-зелёный", "зелёный", "весенне-зелёный",
+    "голубой", "лазурный", "синий", "фиолетовый", "пурпурный", "малиновый"
+};
+
+// Значения тега EXIF Orientation 1-8
+const char *const OrientationNames[8] = {
+    "Обычная", "Отражена по горизонтали", "Повёрнута на 180°", "Отражена по вертикали",
+    "Отражена и повёрнута на 90° влево", "Повёрнута на 90° вправо",
+    "Отражена и повёрнута на 90° вправо", "Повёрнута на 90° влево"
+};
+
+QString colorName(QRgb color)
+{
+    return QString("#%1").arg(color & 0xFFFFFF, 6, 16, QChar('0')).toUpper();
+}
+
+}
+
+ResultModel::ResultModel(QObject *parent)
+    : QAbstractTableModel(parent), thumbnails(nullptr), profiler(nullptr)
+{
+}
+
+int ResultModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : paths.count();
+}
+
+int ResultModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant ResultModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    int row = index.row();
+    if (role == Qt::DisplayRole) {
+        StageTimer timer(profiler, AnalysisProfiler::TextStage);
+        return displayText(row, index.column());
+    }
+
+    // Образцы цветов рисуются только для видимых строк, как и текст
+    bool hasColors = dominantCounts[row] > 0;
+    if (role == Qt::DecorationRole && index.column() == MeanColorColumn && hasColors) {
+        return QColor::fromRgb(meanColors[row]);
+    }
+    if (role == Qt::DecorationRole && index.column() == PaletteColumn && hasColors) {
+        QPixmap strip(48, 16);
+        strip.fill(Qt::transparent);
+        QPainter painter(&strip);
+        int left = 0;
+        int count = dominantCounts[row];
+        for (int i = 0; i < count; ++i) {
+            int right = i + 1 < count ? left + dominantShares[row * ColorSummary::MaxDominant + i] * strip.width() / 100
+                                      : strip.width();
+            painter.fillRect(left, 0, qMax(right - left, 1), strip.height(),
+                             QColor::fromRgb(dominantColors[row * ColorSummary::MaxDominant + i]));
+            left = right;
+        }
+        return strip;
+    }
+    if (role == Qt::ToolTipRole && (index.column() == MeanColorColumn || index.column() == PaletteColumn) && hasColors) {
+        return getHueInfo(row);
+    }
+
+    if (role == Qt::ToolTipRole && index.column() == SimilarColumn && groupIds[row] >= 0) {
+        return getSimilarInfo(row);
+    }
+
+    if (role == Qt::ToolTipRole && index.column() >= CameraColumn && index.column() <= OrientationColumn
+        && metadata.contains(row)) {
+        return getMetadataInfo(metadata.value(row));
+    }
+
+    if (role == Qt::ToolTipRole && index.column() == NameColumn && statuses[row] == ImageInfo::Ok) {
+        QString filePath = paths.path(row);
+        QString fileName = paths.fileName(row).toString();
+        QString tooltipHtml = QString(
+                                  "<b>%1</b><br>"
+                                  "<font color='gray'>%2</font>"
+                                  ).arg(fileName).arg(filePath);
+
+        // Оригинал здесь не читается: если миниатюры ещё нет, она заказывается в фоне
+        QString thumbnail = thumbnails ? thumbnails->cachedThumbnail(filePath) : QString();
+        if (!thumbnail.isEmpty()) {
+            tooltipHtml += QString("<br><br><img src='file:///%1' style='border: 1px solid #ccc;'>").arg(thumbnail);
+        } else if (thumbnails) {
+            thumbnails->request(filePath);
+        }
+        return tooltipHtml;
+    }
+
+    return QVariant();
+}
+
+QVariant ResultModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    if (role == Qt::DisplayRole) {
+        switch (section) {
+        case NameColumn:        return QString("Имя файла");
+        case SizeColumn:        return QString("Размер (px)");
+        case DpiColumn:         return QString("Разрешение (DPI)");
+        case DepthColumn:       return QString("Глубина цвета");
+        case CompressionColumn: return QString("Сжатие");
+        case MeanColorColumn:   return QString("Средний цвет");
+        case PaletteColumn:     return QString("Основные цвета");
+        case SimilarColumn:     return QString("Похожие");
+        case CameraColumn:      return QString("Камера");
+        case CaptureTimeColumn: return QString("Дата съёмки");
+        case OrientationColumn: return QString("Ориентация");
+        case ExtraColumn:       return QString("Дополнительная информация");
+        }
+    }
+
+    // Tooltip'ы для заголовков столбцов
+    if (role == Qt::ToolTipRole) {
+        switch (section) {
+        case SizeColumn:
+            return QString(
+                "<b>Размер изображения</b><br>"
+                "<p>Ширина и высота изображения<br>"
+                "в пикселях.</p>"
+                );
+        case DpiColumn:
+            return QString(
+                "<b>Разрешение (DPI)</b><p>"
+                "Единица измерения разрешения изображения,<br>"
+                "указывающая, сколько точек (пикселей)<br>"
+                "будет напечатано на одном дюйме.<br>"
+                "Чем выше значение DPI, тем более<br>"
+                "детализированным и четким будет<br>"
+                "распечатанное изображение.</p>"
+                );
+        case DepthColumn:
+            return QString(
+                "<b>Глубина цвета</b><p>"
+                "Количество бит, используемых для<br>"
+                "представления цвета каждого пикселя<br>"
+                "в изображении.<br>"
+                "Чем выше глубина цвета, тем больше<br>"
+                "уникальных цветов может отобразить<br>"
+                "изображение или монитор.</p>"
+                );
+        case CompressionColumn:
+            return QString(
+                "Алгоритмы, которыми происходит сжатие<br>"
+                "(Уменьшение размера файла)<br>"
+                "• <b>Без потерь</b> - PNG, GIF, PCX<br>"
+                "• <b>С потерями</b> - JPEG<br>"
+                "• <b>Без сжатия</b> - BMP<br>"
+                "Для JPEG - качество по таблицам<br>"
+                "квантования (шкала libjpeg, 1-100)<br>"
+                "и прореживание цветности."
+                );
+        case MeanColorColumn:
+            return QString(
+                "<b>Средний цвет</b><p>"
+                "Среднее по всем пикселям в линейном<br>"
+                "свете, как смешал бы их свет, а не<br>"
+                "среднее кодов sRGB.<br>"
+                "Считается вместе со статистикой по пикселям.</p>"
+                );
+        case PaletteColumn:
+            return QString(
+                "<b>Основные цвета</b><p>"
+                "До %1 цветов медианным сечением<br>"
+                "и доля пикселей каждого из них.<br>"
+                "В подсказке ячейки - распределение<br>"
+                "пикселей по тонам.</p>"
+                ).arg(int(ColorSummary::MaxDominant));
+        case SimilarColumn:
+            return QString(
+                "<b>Похожие изображения</b><p>"
+                "Группы изображений с близкими<br>"
+                "перцептивными хэшами (dHash и pHash):<br>"
+                "копии, пересжатые и уменьшенные<br>"
+                "версии одного изображения.<br>"
+                "Крупные группы получают меньшие номера.</p>"
+                );
+        case CameraColumn:
+        case CaptureTimeColumn:
+        case OrientationColumn:
+            return QString(
+                "<b>Метаданные EXIF</b><p>"
+                "Камера, время съёмки и ориентация<br>"
+                "из EXIF (JPEG, PNG, TIFF).<br>"
+                "Ориентацию учитывают просмотрщики:<br>"
+                "пиксели в файле могут быть повёрнуты.<br>"
+                "В подсказке ячейки - встроенная<br>"
+                "миниатюра, XMP и профиль ICC.</p>"
+                );
+        case ExtraColumn:
+            return QString(
+                "<b>Размер файла</b><p>"
+                "Количество КБ, которое занимает<br>"
+                "файл на диске.</p><p>"
+                "<b>Поддержка прозрачности</b></p><p>"
+                "Возможность просмотра объектов<br>"
+                "сквозь другие объекты</p>"
+                "<p><b>Цветовая модель</b></p>"
+                "<p>Способ представления цветов<br>"
+                "в виде числовых значений:<br>"
+                "• <b>цветное</b><br>"
+                "• <b>чёрно-белое</b><br></p>"
+                );
+        }
+    }
+
+    return QVariant();
+}
+
+void ResultModel::append(const QList<ImageInfo> &batch)
+{
+    if (batch.isEmpty()) {
+        return;
+    }
+
+    // Номер строки - номер пути в paths, поэтому путь, который не
+    // добавился (повтор), строки не получает
+    QList<const ImageInfo *> added;
+    int first = paths.count();
+    for (const ImageInfo &image : batch) {
+        if (paths.add(image.filePath)) {
+            added.append(&image);
+        }
+    }
+    if (added.isEmpty()) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), first, first + added.count() - 1);
+    resizeColumns(first + added.count());
+    for (int i = 0; i < added.count(); ++i) {
+        setRow(first + i, *added[i]);
+    }
+    endInsertRows();
+}
+
+void ResultModel::update(const QList<ImageInfo> &batch)
+{
+    QList<ImageInfo> added;
+    for (const ImageInfo &image : batch) {
+        int row = paths.indexOf(image.filePath);
+        if (row < 0) {
+            added.append(image);
+            continue;
+        }
+
+        // Перерисовывается только изменившаяся строка
+        setRow(row, image);
+        emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+    }
+    append(added);
+}
+
+void ResultModel::resizeColumns(int count)
+{
+    fileSizes.resize(count);
+    widths.resize(count);
+    heights.resize(count);
+    dpis.resize(count);
+    colorCounts.resize(count);
+    frameCounts.resize(count);
+    uniqueColors.resize(count);
+    uniqueColorsErrors.resize(count);
+    sampleBudgets.resize(count);
+    sampledPixels.resize(count);
+    effectiveBits.resize(count);
+    compressionCodes.resize(count);
+    meanColors.resize(count);
+    dominantColors.resize(count * ColorSummary::MaxDominant);
+    dominantShares.resize(count * ColorSummary::MaxDominant);
+    dominantCounts.resize(count);
+    hueHistograms.resize(count * ColorSummary::HueBins);
+    dHashes.resize(count);
+    pHashes.resize(count);
+    groupIds.resize(count, -1);
+    depths.resize(count);
+    statuses.resize(count);
+    headerFormats.resize(count);
+    compressions.resize(count);
+    lzwCodeSizes.resize(count);
+    jpegQualities.resize(count);
+    chromaSubsamplings.resize(count);
+    suffixIds.resize(count);
+    actualFormatIds.resize(count);
+    flags.resize(count);
+}
+
+void ResultModel::setRow(int row, const ImageInfo &image)
+{
+    const ImageHeader &header = image.header;
+    quint16 rowFlags = (image.hasAlpha ? HasAlpha : 0)
+                       | (image.grayscale ? Grayscale : 0)
+                       | (image.animated ? Animated : 0)
+                       | (image.formatMismatch ? FormatMismatch : 0)
+                       | (image.pixelStats ? PixelStats : 0)
+                       | (header.interlaced ? Interlaced : 0)
+                       | (header.progressive ? Progressive : 0)
+                       | (header.lossless ? Lossless : 0)
+                       | (image.perceptualHash ? PerceptualHash : 0)
+                       | (header.qualityExact ? QualityExact : 0)
+                       | (header.optimizedHuffman ? CustomHuffman : 0);
+
+    fileSizes[row] = image.fileSize;
+    widths[row] = image.size.width();
+    heights[row] = image.size.height();
+    dpis[row] = image.dpi;
+    colorCounts[row] = image.colorCount;
+    frameCounts[row] = image.frameCount;
+    uniqueColors[row] = image.uniqueColors;
+    uniqueColorsErrors[row] = image.uniqueColorsError;
+    sampleBudgets[row] = image.sampleBudget;
+    sampledPixels[row] = image.sampledPixels;
+    effectiveBits[row] = quint8(image.effectiveBits);
+    compressionCodes[row] = header.compressionCode;
+    const ColorSummary &colors = image.colors;
+    int dominant = int(qMin(colors.dominant.size(), qsizetype(ColorSummary::MaxDominant)));
+    meanColors[row] = colors.mean;
+    dominantCounts[row] = quint8(dominant);
+    for (int i = 0; i < dominant; ++i) {
+        dominantColors[row * ColorSummary::MaxDominant + i] = colors.dominant[i];
+        dominantShares[row * ColorSummary::MaxDominant + i] = colors.dominantShares[i];
+    }
+    for (int i = 0; i < ColorSummary::HueBins; ++i) {
+        hueHistograms[row * ColorSummary::HueBins + i] = colors.hueHistogram[i];
+    }
+    dHashes[row] = image.dHash;
+    pHashes[row] = image.pHash;
+    if (!image.png.isNull()) {
+        pngs.insert(row, image.png);
+    } else {
+        pngs.remove(row);
+    }
+    if (!image.metadata.isNull()) {
+        metadata.insert(row, image.metadata);
+    } else {
+        metadata.remove(row);
+    }
+    if (image.animation.frames > 1) {
+        animations.insert(row, image.animation);
+    } else {
+        animations.remove(row);
+    }
+    depths[row] = quint8(qBound(0, image.depth, 255));
+    statuses[row] = quint8(image.status);
+    headerFormats[row] = quint8(header.format);
+    compressions[row] = quint8(header.compression);
+    lzwCodeSizes[row] = quint8(header.lzwCodeSize);
+    jpegQualities[row] = quint8(header.quality);
+    chromaSubsamplings[row] = quint8(header.chromaSubsampling);
+    suffixIds[row] = internFormat(image.format);
+    actualFormatIds[row] = internFormat(image.actualFormat);
+    flags[row] = rowFlags;
+}
+
+void ResultModel::clear()
+{
+    beginResetModel();
+    paths.clear();
+    fileSizes.clear();
+    widths.clear();
+    heights.clear();
+    dpis.clear();
+    colorCounts.clear();
+    frameCounts.clear();
+    uniqueColors.clear();
+    uniqueColorsErrors.clear();
+    sampleBudgets.clear();
+    sampledPixels.clear();
+    effectiveBits.clear();
+    compressionCodes.clear();
+    meanColors.clear();
+    dominantColors.clear();
+    dominantShares.clear();
+    dominantCounts.clear();
+    hueHistograms.clear();
+    dHashes.clear();
+    pHashes.clear();
+    groupIds.clear();
+    groups.clear();
+    animations.clear();
+    metadata.clear();
+    pngs.clear();
+    depths.clear();
+    statuses.clear();
+    headerFormats.clear();
+    compressions.clear();
+    lzwCodeSizes.clear();
+    jpegQualities.clear();
+    chromaSubsamplings.clear();
+    suffixIds.clear();
+    actualFormatIds.clear();
+    flags.clear();
+    endResetModel();
+}
+
+ImageInfo ResultModel::info(int row) const
+{
+    quint16 rowFlags = flags[row];
+
+    ImageInfo image;
+    image.filePath = paths.path(row);
+    image.status = ImageInfo::Status(statuses[row]);
+    image.format = formatNames[suffixIds[row]];
+    image.actualFormat = formatNames[actualFormatIds[row]];
+    image.formatMismatch = rowFlags & FormatMismatch;
+    image.fileSize = fileSizes[row];
+    image.size = QSize(widths[row], heights[row]);
+    image.dpi = dpis[row];
+    image.depth = depths[row];
+    image.colorCount = colorCounts[row];
+    image.frameCount = frameCounts[row];
+    image.animation = animations.value(row);
+    image.metadata = metadata.value(row);
+    image.png = pngs.value(row);
+    image.uniqueColors = uniqueColors[row];
+    image.uniqueColorsError = uniqueColorsErrors[row];
+    image.sampleBudget = sampleBudgets[row];
+    image.sampledPixels = sampledPixels[row];
+    image.effectiveBits = effectiveBits[row];
+    image.hasAlpha = rowFlags & HasAlpha;
+    image.grayscale = rowFlags & Grayscale;
+    image.animated = rowFlags & Animated;
+    image.pixelStats = rowFlags & PixelStats;
+    image.perceptualHash = rowFlags & PerceptualHash;
+    image.dHash = dHashes[row];
+    image.pHash = pHashes[row];
+
+    ColorSummary &colors = image.colors;
+    colors.mean = meanColors[row];
+    for (int i = 0; i < dominantCounts[row]; ++i) {
+        colors.dominant.append(dominantColors[row * ColorSummary::MaxDominant + i]);
+        colors.dominantShares.append(dominantShares[row * ColorSummary::MaxDominant + i]);
+    }
+    for (int i = 0; i < ColorSummary::HueBins; ++i) {
+        colors.hueHistogram[i] = hueHistograms[row * ColorSummary::HueBins + i];
+    }
+
+    image.header = rowHeader(row);
+    return image;
+}
+
+ImageHeader ResultModel::rowHeader(int row) const
+{
+    quint16 rowFlags = flags[row];
+
+    ImageHeader header;
+    header.format = ImageHeader::Format(headerFormats[row]);
+    header.compression = ImageHeader::Compression(compressions[row]);
+    header.compressionCode = compressionCodes[row];
+    header.interlaced = rowFlags & Interlaced;
+    header.progressive = rowFlags & Progressive;
+    header.lossless = rowFlags & Lossless;
+    header.lzwCodeSize = lzwCodeSizes[row];
+    header.quality = jpegQualities[row];
+    header.qualityExact = rowFlags & QualityExact;
+    header.chromaSubsampling = chromaSubsamplings[row];
+    header.optimizedHuffman = rowFlags & CustomHuffman;
+    return header;
+}
+
+QString ResultModel::filePath(int row) const
+{
+    return paths.path(row);
+}
+
+void ResultModel::perceptualHashes(QVector<int> &hashRows, QVector<quint64> &pHashList, QVector<quint64> &dHashList) const
+{
+    for (int row = 0; row < paths.count(); ++row) {
+        if (flags[row] & PerceptualHash) {
+            hashRows.append(row);
+            pHashList.append(pHashes[row]);
+            dHashList.append(dHashes[row]);
+        }
+    }
+}
+
+void ResultModel::setGroups(const QList<QList<int>> &similarGroups)
+{
+    groups = similarGroups;
+    groupIds.fill(-1);
+    for (int group = 0; group < groups.count(); ++group) {
+        for (int row : groups[group]) {
+            if (row < groupIds.count()) {
+                groupIds[row] = group;
+            }
+        }
+    }
+    if (paths.count() > 0) {
+        emit dataChanged(index(0, SimilarColumn), index(paths.count() - 1, SimilarColumn));
+    }
+}
+
+int ResultModel::groupCount() const
+{
+    return int(groups.count());
+}
+
+void ResultModel::setThumbnails(ThumbnailService *service)
+{
+    thumbnails = service;
+}
+
+void ResultModel::setProfiler(AnalysisProfiler *analysisProfiler)
+{
+    profiler = analysisProfiler;
+}
+
+quint16 ResultModel::internFormat(const QString &name)
+{
+    int id = formatNames.indexOf(name);
+    if (id < 0) {
+        id = formatNames.count();
+        formatNames.append(name);
+    }
+    return quint16(id);
+}
+
+QString ResultModel::displayText(int row, int column) const
+{
+    // Каждый столбец читает только свои массивы, ImageInfo целиком собирается лишь для ExtraColumn
+    if (column == NameColumn) {
+        return paths.fileName(row).toString();
+    }
+
+    ImageInfo::Status status = ImageInfo::Status(statuses[row]);
+    if (column == CompressionColumn) {
+        return getCompressionInfo(row);
+    }
+    if (status == ImageInfo::ReadError) {
+        switch (column) {
+        case SizeColumn:  return "Ошибка чтения";
+        case ExtraColumn: return "Формат не поддерживается";
+        default:          return "N/A";
+        }
+    }
+    if (column == SizeColumn) {
+        return QString("%1 x %2").arg(widths[row]).arg(heights[row]);
+    }
+    if (status == ImageInfo::LoadError) {
+        return column == ExtraColumn ? "Ошибка загрузки данных" : "N/A";
+    }
+
+    switch (column) {
+    case DpiColumn:         return dpis[row] > 0 ? QString("%1").arg(dpis[row]) : "Не указано";
+    case DepthColumn:       return getColorDepthInfo(row);
+    case MeanColorColumn:   return dominantCounts[row] == 0 ? "Не посчитано" : colorName(meanColors[row]);
+    case PaletteColumn:     return getPaletteInfo(row);
+    case SimilarColumn:
+        if (groupIds[row] >= 0) {
+            return QString("Группа %1, файлов: %2").arg(groupIds[row] + 1).arg(groups[groupIds[row]].count());
+        }
+        return (flags[row] & PerceptualHash) ? "Нет" : "Не посчитано";
+    case CameraColumn:
+    case CaptureTimeColumn:
+    case OrientationColumn: {
+        auto found = metadata.constFind(row);
+        if (found == metadata.constEnd()) {
+            return QString();
+        }
+        const ImageMetadata &data = found.value();
+        if (column == CameraColumn) {
+            return data.camera();
+        }
+        if (column == CaptureTimeColumn) {
+            return data.captureTime.isValid() ? data.captureTime.toString("dd.MM.yyyy HH:mm:ss") : QString();
+        }
+        return data.orientation >= 1 && data.orientation <= 8 ? OrientationNames[data.orientation - 1] : "";
+    }
+    case ExtraColumn:       return getExtraInfo(info(row));
+    }
+    return QString();
+}
+
+QString ResultModel::getExtraInfo(const ImageInfo &image) const
+{
+    QStringList info;
+
+    info << QString("Размер файла: %1 КБ").arg(image.fileSize / 1024);
+
+    if (image.formatMismatch) {
+        info << QString("Внимание: по содержимому это %1").arg(image.actualFormat);
+    }
+
+    const FrameSummary &frames = image.animation;
+    if (image.animated && !frames.isNull()) {
+        info << QString("Анимация: %1 кадров, %2 с").arg(frames.frames).arg(frames.duration / 1000.0, 0, 'f', 2);
+        if (frames.loopCount < 0) {
+            info << "Повтор: нет";
+        } else if (frames.loopCount == 0) {
+            info << "Повтор: бесконечно";
+        } else {
+            info << QString("Повторов: %1").arg(frames.loopCount);
+        }
+        if (frames.minDelay != frames.maxDelay) {
+            info << QString("Задержка кадров: %1-%2 мс").arg(frames.minDelay).arg(frames.maxDelay);
+        } else {
+            info << QString("Задержка кадров: %1 мс").arg(frames.minDelay);
+        }
+        if (frames.localPalettes > 0) {
+            info << QString("Кадров со своей палитрой: %1").arg(frames.localPalettes);
+        }
+        if (frames.partialFrames > 0) {
+            info << QString("Кадров меньше холста: %1").arg(frames.partialFrames);
+        }
+    } else if (image.animated) {
+        info << QString("Анимация: %1 кадров").arg(image.frameCount);
+    } else if (image.frameCount > 1) {
+        info << QString("Страниц: %1").arg(image.frameCount);
+        if (frames.reducedPages > 0) {
+            info << QString("Из них уменьшенных копий: %1").arg(frames.reducedPages);
+        }
+    }
+
+    if (image.hasAlpha) {
+        info << "Прозрачность: да";
+    } else {
+        info << "Прозрачность: нет";
+    }
+
+    if (image.grayscale) {
+        info << "Цветовая модель: градации серого";
+    } else {
+        info << "Цветовая модель: цветное";
+    }
+
+    if (image.pixelStats && image.sampledPixels > 0) {
+        // Отсутствие цветных или прозрачных пикселей в выборке - только граница их доли
+        double missed = PixelSampler::missedFraction(image.sampledPixels) * 100;
+        info << QString("Оценка по выборке из %1 пикселей (%2%)")
+                    .arg(image.sampledPixels).arg(PixelSampler::Confidence * 100);
+        info << QString("Различных цветов: ~%1 ± %2").arg(image.uniqueColors).arg(image.uniqueColorsError);
+        if (image.grayscale) {
+            info << QString("Цветных пикселей: меньше %1%").arg(missed, 0, 'g', 2);
+        }
+        if (!image.hasAlpha) {
+            info << QString("Прозрачных пикселей: меньше %1%").arg(missed, 0, 'g', 2);
+        }
+    } else if (image.pixelStats) {
+        info << QString("Различных цветов: %1").arg(image.uniqueColors);
+        if (image.effectiveBits > 0 && image.effectiveBits < 8) {
+            info << QString("Фактически бит на канал: %1").arg(image.effectiveBits);
+        }
+    }
+
+    if (!image.colors.isNull() && !image.grayscale) {
+        int hue = image.colors.dominantHue();
+        if (hue >= 0) {
+            info << QString("Преобладающий тон: %1 (%2%)").arg(HueNames[hue]).arg(int(image.colors.hueHistogram[hue]));
+        } else {
+            info << "Преобладающий тон: нет, цвета почти не насыщены";
+        }
+    }
+
+    // Специфичная информация для форматов
+    if (image.header.format == ImageHeader::Gif) {
+        int colors = image.colorCount;
+        if (colors > 0) {
+            info << QString("Цветов в палитре: %1").arg(colors);
+        }
+    } else if (!image.png.isNull()) {
+        info << getPngInfo(image.png);
+    } else if (image.header.format == ImageHeader::Jpeg && !image.header.lossless) {
+        info << (image.header.optimizedHuffman ? "Таблицы Хаффмана: оптимизированные"
+                                               : "Таблицы Хаффмана: стандартные");
+    }
+    return info.join("\n");
+}
+
+QString ResultModel::getCompressionInfo(int row) const
+{
+    // Сжатие по заголовку файла, а не по расширению
+    ImageHeader header = rowHeader(row);
+    if (header.format == ImageHeader::Unknown) {
+        return "Неизвестно";
+    }
+
+    switch (header.compression) {
+    case ImageHeader::NoCompression:
+        return "Без сжатия";
+    case ImageHeader::RleCompression:
+        if (header.format == ImageHeader::Bmp) {
+            return QString("RLE%1 (без потерь)").arg(header.compressionCode == 2 ? 4 : 8);
+        }
+        return "RLE (без потерь)";
+    case ImageHeader::LzwCompression:
+        if (header.format == ImageHeader::Gif && header.lzwCodeSize > 0) {
+            return QString("LZW, код %1 бит%2 (без потерь)")
+                .arg(header.lzwCodeSize + 1)
+                .arg(header.interlaced ? ", чересстрочный" : "");
+        }
+        return "LZW (без потерь)";
+    case ImageHeader::DeflateCompression:
+        {
+            auto png = pngs.constFind(row);
+            if (png != pngs.constEnd() && png->idatSize > 0) {
+                return QString("Deflate%1, %2:1 (без потерь)")
+                    .arg(header.interlaced ? ", Adam7" : "")
+                    .arg(png->compressionRatio(), 0, 'f', 1);
+            }
+        }
+        return header.interlaced ? "Deflate, Adam7 (без потерь)" : "Deflate (без потерь)";
+    case ImageHeader::JpegCompression:
+        if (header.format != ImageHeader::Jpeg) {
+            return "JPEG (с потерями)";
+        }
+        if (header.lossless) {
+            return "JPEG lossless (без потерь)";
+        }
+        {
+            // "~" - таблицы не от libjpeg, качество оценено по ближайшей
+            QString info = header.progressive ? "JPEG progressive" : "JPEG baseline";
+            if (header.quality > 0) {
+                info += QString(", качество %1%2").arg(header.qualityExact ? "" : "~").arg(header.quality);
+            }
+            QString subsampling = ImageHeaders::subsamplingName(header.chromaSubsampling);
+            if (!subsampling.isEmpty()) {
+                info += ", " + subsampling;
+            }
+            return info + " (с потерями)";
+        }
+    case ImageHeader::PackBitsCompression:
+        return "PackBits (без потерь)";
+    case ImageHeader::CcittCompression:
+        return "CCITT (без потерь)";
+    default:
+        return QString("Код сжатия %1").arg(header.compressionCode);
+    }
+}
+
+QString ResultModel::getPaletteInfo(int row) const
+{
+    if (dominantCounts[row] == 0) {
+        return "Не посчитано";
+    }
+
+    QStringList info;
+    for (int i = 0; i < dominantCounts[row]; ++i) {
+        int slot = row * ColorSummary::MaxDominant + i;
+        info << QString("%1 %2%").arg(colorName(dominantColors[slot])).arg(int(dominantShares[slot]));
+    }
+    return info.join(", ");
+}
+
+QString ResultModel::getHueInfo(int row) const
+{
+    // Подсказка: распределение насыщенных пикселей по тонам, остальное - ненасыщенные
+    QString html = QString("<b>Средний цвет:</b> %1<br><b>Тона:</b>").arg(colorName(meanColors[row]));
+    int chromatic = 0;
+    for (int i = 0; i < ColorSummary::HueBins; ++i) {
+        int share = hueHistograms[row * ColorSummary::HueBins + i];
+        chromatic += share;
+        if (share > 0) {
+            html += QString("<br>%1°-%2° %3: %4%").arg(i * 30).arg(i * 30 + 30).arg(HueNames[i]).arg(share);
+        }
+    }
+    html += QString("<br>без выраженного тона: %1%").arg(qMax(0, 100 - chromatic));
+    return html;
+}
+
+QString ResultModel::getSimilarInfo(int row) const
+{
+    // Не больше 10 имён, чтобы подсказка помещалась на экране
+    const QList<int> &group = groups[groupIds[row]];
+    QStringList names;
+    for (int other : group) {
+        if (other != row && names.count() < 10) {
+            names << paths.fileName(other).toString();
+        }
+    }
+    QString html = QString("<b>Похожие файлы:</b><br>%1").arg(names.join("<br>"));
+    if (group.count() - 1 > names.count()) {
+        html += QString("<br>и ещё %1").arg(group.count() - 1 - names.count());
+    }
+    return html;
+}
+
+QString ResultModel::getMetadataInfo(const ImageMetadata &data) const
+{
+    QStringList lines;
+    if (data.thumbnailSize > 0) {
+        lines << QString("Встроенная миниатюра: %1x%2, %3 КБ")
+                     .arg(data.thumbnailWidth).arg(data.thumbnailHeight).arg((data.thumbnailSize + 1023) / 1024);
+    }
+    if (data.exifSize > 0) {
+        lines << QString("EXIF: %1 байт").arg(data.exifSize);
+    }
+    if (data.xmpSize > 0) {
+        lines << QString("XMP: %1 байт").arg(data.xmpSize);
+    }
+    if (data.iccSize > 0) {
+        QString icc = QString("Профиль ICC: %1 байт").arg(data.iccSize);
+        if (!data.iccDescription.isEmpty()) {
+            icc += ", " + data.iccDescription.toHtmlEscaped();
+        }
+        if (!data.iccColorSpace.isEmpty()) {
+            icc += QString(" (%1)").arg(data.iccColorSpace);
+        }
+        lines << icc;
+    }
+    return lines.join("<br>");
+}
+
+QStringList ResultModel::getPngInfo(const PngInfo &png) const
+{
+    static const char *const ColorTypes[7] = {
+        "серый", "", "RGB", "палитра", "серый с альфой", "", "RGBA"
+    };
+    static const struct { PngInfo::Chunk chunk; const char *name; } ChunkNames[] = {
+        { PngInfo::Gamma, "gAMA" }, { PngInfo::IccProfile, "iCCP" }, { PngInfo::PhysicalSize, "pHYs" },
+        { PngInfo::Srgb, "sRGB" }, { PngInfo::Chromaticity, "cHRM" }, { PngInfo::Background, "bKGD" },
+        { PngInfo::Transparency, "tRNS" }, { PngInfo::Text, "текст" }, { PngInfo::Time, "tIME" },
+        { PngInfo::Exif, "eXIf" }
+    };
+
+    QStringList info;
+    info << QString("PNG: %1 бит на канал, %2%3")
+                .arg(png.bitDepth)
+                .arg(png.colorType < 7 ? ColorTypes[png.colorType] : "?")
+                .arg(png.interlaced ? ", Adam7" : "");
+    // Сжатие - отношение распакованных строк (с байтом фильтра) к сумме IDAT
+    info << QString("IDAT: %1 КБ в %2 чанках, без сжатия %3 КБ")
+                .arg((png.idatSize + 1023) / 1024).arg(png.idatCount).arg((png.rawSize + 1023) / 1024);
+
+    QStringList names;
+    for (const auto &entry : ChunkNames) {
+        if (png.chunks & entry.chunk) {
+            names << (entry.chunk == PngInfo::Gamma && png.gamma > 0
+                          ? QString("gAMA %1").arg(png.gamma / 100000.0, 0, 'f', 5) : QString(entry.name));
+        }
+    }
+    if (!names.isEmpty()) {
+        info << QString("Чанки: %1").arg(names.join(", "));
+    }
+    if (png.wastedSize() > 0) {
+        info << QString("Лишние метаданные: %1 байт").arg(png.wastedSize());
+    }
+    return info;
+}
+
+QString ResultModel::getColorDepthInfo(int row) const
+{
+    int depth = depths[row];
+    QString info = QString("%1 бит").arg(depth);
+
+    // Только базовая информация, которую можно получить из QImage
+    if (depth == 1) {
+        info += " (монохром)";
+    } else if (depth == 8) {
+        if (colorCounts[row] > 0) {
+            info += " (индексированные цвета)";
+        } else {
+            info += " (градации серого)";
+        }
+    } else if (depth == 24) {
+        info += " (True Color)";
+    } else if (depth == 32) {
+        info += (flags[row] & HasAlpha) ? " (True Color + Alpha)" : " (True Color)";
+    }
+
+    return info;
+}
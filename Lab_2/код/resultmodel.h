@@ -0,0 +1,130 @@
+#ifndef RESULTMODEL_H
+#define RESULTMODEL_H
+
+#include <QAbstractTableModel>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include "imageanalysis.h"
+#include "pathstore.h"
+
+class ThumbnailService;
+class AnalysisProfiler;
+
+// Результаты анализа для QTableView. Каждое поле хранится отдельным
+// плотным массивом, а текст ячеек собирается только при запросе data(),
+// то есть для строк, которые видны на экране.
+class ResultModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        NameColumn, SizeColumn, DpiColumn, DepthColumn, CompressionColumn, MeanColorColumn, PaletteColumn,
+        SimilarColumn, CameraColumn, CaptureTimeColumn, OrientationColumn, ExtraColumn, ColumnCount
+    };
+
+private:
+    enum Flag : quint16 {
+        HasAlpha       = 0x01,
+        Grayscale      = 0x02,
+        Animated       = 0x04,
+        FormatMismatch = 0x08,
+        PixelStats     = 0x10,
+        Interlaced     = 0x20,
+        Progressive    = 0x40,
+        Lossless       = 0x80,
+        PerceptualHash = 0x100,
+        QualityExact   = 0x200,
+        CustomHuffman  = 0x400
+    };
+
+    PathStore paths;           // номер пути совпадает с номером строки
+    QVector<qint64> fileSizes;
+    QVector<qint64> sampledPixels;
+    QVector<qint32> widths;
+    QVector<qint32> heights;
+    QVector<qint32> dpis;
+    QVector<qint32> colorCounts;
+    QVector<qint32> frameCounts;
+    QVector<qint32> uniqueColors;
+    QVector<qint32> uniqueColorsErrors;
+    QVector<qint32> sampleBudgets;
+    QVector<qint32> compressionCodes;
+    QVector<QRgb> meanColors;
+    QVector<QRgb> dominantColors;      // по ColorSummary::MaxDominant на строку
+    QVector<quint8> dominantShares;    // так же
+    QVector<quint8> dominantCounts;
+    QVector<quint8> hueHistograms;     // по ColorSummary::HueBins на строку
+    QVector<quint64> dHashes;
+    QVector<quint64> pHashes;
+    QVector<qint32> groupIds;          // номер группы похожих или -1
+    QList<QList<int>> groups;          // строки каждой группы
+    QHash<int, FrameSummary> animations;   // только строки с несколькими кадрами
+    QHash<int, ImageMetadata> metadata;     // только строки с EXIF, XMP или ICC
+    QHash<int, PngInfo> pngs;               // только строки PNG
+    QVector<quint8> depths;
+    QVector<quint8> effectiveBits;
+    QVector<quint8> statuses;
+    QVector<quint8> headerFormats;
+    QVector<quint8> compressions;
+    QVector<quint8> lzwCodeSizes;
+    QVector<quint8> jpegQualities;
+    QVector<quint8> chromaSubsamplings;
+    QVector<quint16> suffixIds;
+    QVector<quint16> actualFormatIds;
+    QVector<quint16> flags;
+
+    // Имена форматов и расширения повторяются, в строках хранится только индекс
+    QStringList formatNames;
+
+    ThumbnailService *thumbnails;
+    AnalysisProfiler *profiler;
+
+    quint16 internFormat(const QString &name);
+    void resizeColumns(int count);
+    void setRow(int row, const ImageInfo &image);
+    QString displayText(int row, int column) const;
+    ImageHeader rowHeader(int row) const;
+
+    QString getExtraInfo(const ImageInfo &image) const;
+    QString getCompressionInfo(int row) const;
+    QString getColorDepthInfo(int row) const;
+    QString getPaletteInfo(int row) const;
+    QString getHueInfo(int row) const;
+    QString getSimilarInfo(int row) const;
+    QString getMetadataInfo(const ImageMetadata &data) const;
+    QStringList getPngInfo(const PngInfo &png) const;
+
+public:
+    explicit ResultModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void append(const QList<ImageInfo> &batch);
+
+    // Заменяет строки с теми же путями, новые пути добавляются в конец
+    void update(const QList<ImageInfo> &batch);
+    void clear();
+
+    // Собирает ImageInfo обратно из столбцов
+    ImageInfo info(int row) const;
+    QString filePath(int row) const;
+
+    // Строки с посчитанными хэшами, для поиска похожих
+    void perceptualHashes(QVector<int> &hashRows, QVector<quint64> &pHashList, QVector<quint64> &dHashList) const;
+    // Группы похожих - номера строк; заменяют прежние
+    void setGroups(const QList<QList<int>> &similarGroups);
+    int groupCount() const;
+
+    // Подсказка с именем файла показывает миниатюру только из кэша
+    void setThumbnails(ThumbnailService *service);
+
+    // Замер времени сборки текста ячеек, nullptr - без замера
+    void setProfiler(AnalysisProfiler *analysisProfiler);
+};
+
+#endif // RESULTMODEL_H
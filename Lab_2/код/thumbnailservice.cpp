@@ -0,0 +1,258 @@
+#include "thumbnailservice.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QImageReader>
+#include <QImage>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+ThumbnailService::ThumbnailService(QObject *parent)
+    : QObject(parent), stopping(false)
+{
+    // Подсказки не должны отнимать все потоки у анализа
+    pool.setMaxThreadCount(2);
+}
+
+ThumbnailService::~ThumbnailService()
+{
+    stopping = true;
+    pool.clear();
+    pool.waitForDone();
+}
+
+bool ThumbnailService::open(const QString &cacheDirectory)
+{
+    directory = cacheDirectory;
+    if (directory.isEmpty()) {
+        directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails";
+    }
+    if (!QDir().mkpath(directory)) {
+        return false;
+    }
+
+    // Индекс путь -> хэш содержимого, чтобы найти миниатюру без чтения оригинала.
+    // Файл только дописывается, поздняя запись для пути заменяет раннюю.
+    indexFile.setFileName(directory + "/index");
+    int records = 0;
+    if (indexFile.open(QIODevice::ReadOnly)) {
+        QDataStream in(&indexFile);
+        in.setVersion(QDataStream::Qt_6_0);
+        while (!in.atEnd()) {
+            QString path;
+            Entry entry;
+            in >> path >> entry.size >> entry.modified >> entry.hash;
+            if (in.status() != QDataStream::Ok) {
+                break;
+            }
+            entries.insert(path, entry);
+            ++records;
+        }
+        indexFile.close();
+    }
+
+    // Повторные записи для одних путей накапливаются, поэтому индекс
+    // переписывается, когда устаревших записей становится больше актуальных
+    if (records > 2 * entries.count()) {
+        compactIndex();
+    }
+    if (!indexFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return false;
+    }
+
+    // Листинг папки не должен задерживать запуск окна
+    pool.start([this]() { trimCache(); });
+    return true;
+}
+
+void ThumbnailService::compactIndex()
+{
+    // Вызывается до открытия индекса или под mutex, пока generate() не пишет в него
+    bool wasOpen = indexFile.isOpen();
+    indexFile.close();
+
+    QSaveFile output(indexFile.fileName());
+    if (output.open(QIODevice::WriteOnly)) {
+        QDataStream out(&output);
+        out.setVersion(QDataStream::Qt_6_0);
+        for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+            out << it.key() << it->size << it->modified << it->hash;
+        }
+        output.commit();
+    }
+
+    if (wasOpen) {
+        indexFile.open(QIODevice::WriteOnly | QIODevice::Append);
+    }
+}
+
+void ThumbnailService::trimCache()
+{
+    // Сначала листинг, потом живые хэши: миниатюра, записанная между ними,
+    // уже будет в entries. Свежие файлы не трогаются на случай, если
+    // generate() ещё не успел добавить запись
+    QFileInfoList files = QDir(directory).entryInfoList(QStringList("*.png"), QDir::Files,
+                                                        QDir::Time | QDir::Reversed);
+    QSet<QString> live;
+    {
+        QMutexLocker locker(&mutex);
+        for (const Entry &entry : std::as_const(entries)) {
+            live.insert(QString::fromLatin1(entry.hash.toHex()));
+        }
+    }
+
+    // Миниатюры, на которые не ссылается ни одна запись, остаются от
+    // изменившихся файлов: новое содержимое получает новое имя
+    QDateTime recent = QDateTime::currentDateTime().addSecs(-60);
+    QFileInfoList kept;
+    qint64 total = 0;
+    for (const QFileInfo &fileInfo : files) {
+        if (stopping) {
+            return;
+        }
+        if (!live.contains(fileInfo.completeBaseName()) && fileInfo.lastModified() < recent) {
+            QFile::remove(fileInfo.filePath());
+        } else {
+            kept.append(fileInfo);
+            total += fileInfo.size();
+        }
+    }
+
+    // Сверх предела удаляются самые старые, вместе с записями индекса
+    QSet<QByteArray> removed;
+    for (int i = 0; i < kept.count() && total > MaxCacheSize && !stopping; ++i) {
+        if (kept[i].lastModified() < recent && QFile::remove(kept[i].filePath())) {
+            total -= kept[i].size();
+            removed.insert(QByteArray::fromHex(kept[i].completeBaseName().toLatin1()));
+        }
+    }
+    if (removed.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (removed.contains(it->hash)) {
+            verified.remove(it.key());
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    compactIndex();
+}
+
+QString ThumbnailService::thumbnailPath(const QByteArray &hash) const
+{
+    return directory + "/" + QString::fromLatin1(hash.toHex()) + ".png";
+}
+
+QString ThumbnailService::cachedThumbnail(const QString &filePath) const
+{
+    // Миниатюра пишется раньше, чем запись попадает в entries, поэтому
+    // для сверенной записи файл миниатюры уже есть
+    QMutexLocker locker(&mutex);
+    auto it = entries.constFind(filePath);
+    if (it == entries.constEnd() || !verified.contains(filePath)) {
+        return QString();
+    }
+    return thumbnailPath(it->hash);
+}
+
+void ThumbnailService::request(const QString &filePath)
+{
+    if (directory.isEmpty()) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&mutex);
+        if (verified.contains(filePath) || inFlight.contains(filePath) || failed.contains(filePath)) {
+            return;
+        }
+        inFlight.insert(filePath);
+    }
+    pool.start([this, filePath]() { generate(filePath); });
+}
+
+void ThumbnailService::invalidate(const QStringList &files)
+{
+    QMutexLocker locker(&mutex);
+    for (const QString &filePath : files) {
+        verified.remove(filePath);
+        failed.remove(filePath);
+    }
+}
+
+void ThumbnailService::generate(const QString &filePath)
+{
+    QFile file(filePath);
+    QFileInfo fileInfo(filePath);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    Entry entry;
+    entry.size = fileInfo.size();
+    entry.modified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    // Файл не менялся с прошлой миниатюры - достаточно отметить запись сверенной
+    {
+        QMutexLocker locker(&mutex);
+        auto it = entries.constFind(filePath);
+        if (it != entries.constEnd() && it->size == entry.size && it->modified == entry.modified) {
+            entry.hash = it->hash;
+        }
+    }
+    if (!entry.hash.isEmpty() && QFile::exists(thumbnailPath(entry.hash))) {
+        QMutexLocker locker(&mutex);
+        inFlight.remove(filePath);
+        verified.insert(filePath);
+        locker.unlock();
+
+        emit thumbnailReady(filePath);
+        return;
+    }
+
+    bool ok = !stopping && file.open(QIODevice::ReadOnly) && hash.addData(&file);
+    if (ok) {
+        entry.hash = hash.result();
+        QString thumbnail = thumbnailPath(entry.hash);
+
+        // Одинаковое содержимое под разными путями даёт одну миниатюру
+        if (!QFile::exists(thumbnail)) {
+            file.seek(0);
+            QImageReader reader(&file);
+            QSize size = reader.size();
+            if (size.width() > ThumbnailSize || size.height() > ThumbnailSize) {
+                reader.setScaledSize(size.scaled(ThumbnailSize, ThumbnailSize, Qt::KeepAspectRatio));
+            }
+
+            // QSaveFile пишет во временный файл и подменяет целиком,
+            // так что подсказка никогда не увидит недописанную миниатюру
+            QImage image = reader.read();
+            QSaveFile output(thumbnail);
+            ok = !image.isNull() && output.open(QIODevice::WriteOnly) && image.save(&output, "PNG") && output.commit();
+        }
+    }
+
+    QMutexLocker locker(&mutex);
+    inFlight.remove(filePath);
+    if (!ok) {
+        if (!stopping) {
+            failed.insert(filePath);
+        }
+        return;
+    }
+    entries.insert(filePath, entry);
+    verified.insert(filePath);
+
+    QDataStream out(&indexFile);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << filePath << entry.size << entry.modified << entry.hash;
+    indexFile.flush();
+    locker.unlock();
+
+    emit thumbnailReady(filePath);
+}
@@ -0,0 +1,69 @@
+#ifndef THUMBNAILSERVICE_H
+#define THUMBNAILSERVICE_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QMutex>
+#include <QHash>
+#include <QSet>
+#include <QFile>
+#include <atomic>
+
+// Миниатюры для подсказок. Изображение декодируется сразу в уменьшенном
+// размере (QImageReader::setScaledSize, для JPEG это масштабирование DCT)
+// в фоновых потоках и кладётся в кэш на диске под именем по SHA-1
+// содержимого файла. Подсказки читают только готовую миниатюру, а размер
+// и время изменения оригинала сверяются в фоне один раз за сеанс.
+class ThumbnailService : public QObject
+{
+    Q_OBJECT
+
+private:
+    struct Entry
+    {
+        qint64 size;
+        qint64 modified;
+        QByteArray hash;
+    };
+
+    QThreadPool pool;
+    QString directory;
+    QFile indexFile;
+
+    mutable QMutex mutex;
+    QHash<QString, Entry> entries;
+    QSet<QString> verified;    // запись сверена с файлом в этом сеансе
+    QSet<QString> inFlight;
+    QSet<QString> failed;      // не читаются через Qt (например, PCX), повторно не заказываются
+    std::atomic<bool> stopping;
+
+    void generate(const QString &filePath);
+    QString thumbnailPath(const QByteArray &hash) const;
+    void compactIndex();
+    void trimCache();
+
+public:
+    static const int ThumbnailSize = 150;
+    // Предел папки кэша; сверх него удаляются самые старые миниатюры
+    static const qint64 MaxCacheSize = 256 * 1024 * 1024;
+
+    explicit ThumbnailService(QObject *parent = nullptr);
+    ~ThumbnailService();
+
+    // По умолчанию кэш лежит в QStandardPaths::CacheLocation/thumbnails
+    bool open(const QString &cacheDirectory = QString());
+
+    // Путь к готовой миниатюре или пустая строка; к диску не обращается
+    QString cachedThumbnail(const QString &filePath) const;
+
+    // Поставить файл в очередь, если его запись ещё не сверена с файлом
+    void request(const QString &filePath);
+
+    // Файлы изменились: сверить их заново при следующем запросе
+    void invalidate(const QStringList &files);
+
+signals:
+    void thumbnailReady(const QString &filePath);
+};
+
+#endif // THUMBNAILSERVICE_H